@@ -0,0 +1,63 @@
+#!/usr/bin/env python3
+"""Сравнение двух отчётов simulator_bench.
+
+Usage: compare.py BASELINE.json CANDIDATE.json [--threshold PCT]
+
+Для каждого бенчмарка, присутствующего в обоих файлах, печатает изменение
+в процентах (положительное — улучшение с учётом направления метрики).
+Код возврата 1, если хотя бы один бенчмарк ухудшился больше порога
+(по умолчанию 10%).
+"""
+import argparse
+import json
+import sys
+
+
+def load(path):
+    with open(path) as f:
+        return {b["name"]: b for b in json.load(f)["benchmarks"]}
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Compare two simulator_bench JSON reports")
+    parser.add_argument("baseline")
+    parser.add_argument("candidate")
+    parser.add_argument("--threshold", type=float, default=10.0,
+                        help="regression threshold in percent (default: 10)")
+    args = parser.parse_args()
+
+    base = load(args.baseline)
+    cand = load(args.candidate)
+
+    regressions = 0
+    width = max((len(n) for n in base if n in cand), default=10)
+    print(f"{'benchmark':<{width}}  {'baseline':>12}  {'candidate':>12}  {'change':>8}")
+    for name in sorted(base):
+        if name not in cand:
+            continue
+        b, c = base[name], cand[name]
+        if b["value"] <= 0 or c["value"] <= 0:
+            continue
+        if b["higher_is_better"]:
+            change = (c["value"] / b["value"] - 1.0) * 100.0
+        else:
+            change = (b["value"] / c["value"] - 1.0) * 100.0
+        flag = ""
+        if change < -args.threshold:
+            flag = "  REGRESSION"
+            regressions += 1
+        print(f"{name:<{width}}  {b['value']:>12.4g}  {c['value']:>12.4g}  {change:>+7.1f}%{flag}")
+
+    missing = set(base) ^ set(cand)
+    if missing:
+        print(f"\n{len(missing)} benchmark(s) present in only one report (skipped)")
+
+    if regressions:
+        print(f"\n{regressions} regression(s) beyond {args.threshold:g}%")
+        return 1
+    print(f"\nNo regressions beyond {args.threshold:g}%")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,165 @@
+// distribution_check.cpp — проверка пакетной генерации распределений
+//
+// Usage: distribution_check [--samples N] [--seed S]
+//
+// Для каждого распределения выборка через sampleBatch сравнивается с
+// выборкой через sample (независимый поток того же генератора)
+// двухвыборочным критерием Колмогорова–Смирнова, а среднее и дисперсия
+// пакетной выборки — с Distribution::mean()/variance(). Проверяются оба
+// базовых генератора, с rate и без. Семя фиксировано, поэтому результат
+// воспроизводим; код возврата 1, если хоть одна проверка не прошла.
+// Запускается из ctest.
+#include "Distribution.h"
+#include "RandomGenerator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr double kMinPValue = 1e-3;   // порог КС: ложная тревога — одна проверка из тысячи
+constexpr double kMaxMomentZ = 5.0;   // порог отклонения моментов в стандартных ошибках
+
+struct Case {
+    std::string name;
+    std::function<std::unique_ptr<Distribution>()> make;
+};
+
+// Статистика D = sup|F₁ − F₂| по отсортированным выборкам
+double ksStatistic(const std::vector<double>& a, const std::vector<double>& b) {
+    size_t i = 0, j = 0;
+    double d = 0.0;
+    while (i < a.size() && j < b.size()) {
+        double x = std::min(a[i], b[j]);
+        while (i < a.size() && a[i] <= x) ++i;
+        while (j < b.size() && b[j] <= x) ++j;
+        d = std::max(d, std::abs(static_cast<double>(i) / a.size() - static_cast<double>(j) / b.size()));
+    }
+    return d;
+}
+
+// Асимптотический p-уровень: Q_KS(λ) = 2 Σ (−1)^(k−1) e^(−2k²λ²),
+// λ = (√nₑ + 0.12 + 0.11/√nₑ)·D (Numerical Recipes, §14.3)
+double ksPValue(double d, size_t n, size_t m) {
+    double en = std::sqrt(static_cast<double>(n) * m / (n + m));
+    double lambda = (en + 0.12 + 0.11 / en) * d;
+    double sum = 0.0, sign = 1.0;
+    for (int k = 1; k <= 100; ++k) {
+        double term = sign * std::exp(-2.0 * k * k * lambda * lambda);
+        sum += term;
+        if (std::abs(term) < 1e-12) break;
+        sign = -sign;
+    }
+    return std::clamp(2.0 * sum, 0.0, 1.0);
+}
+
+struct Moments {
+    double mean = 0.0;
+    double variance = 0.0;
+    double fourth = 0.0;    // центральный четвёртый момент: для ошибки дисперсии
+};
+
+Moments moments(const std::vector<double>& x) {
+    Moments m;
+    for (double v : x) m.mean += v;
+    m.mean /= x.size();
+    for (double v : x) {
+        double d2 = (v - m.mean) * (v - m.mean);
+        m.variance += d2;
+        m.fourth += d2 * d2;
+    }
+    m.variance /= x.size() - 1;
+    m.fourth /= x.size();
+    return m;
+}
+
+// Одна проверка: sample против sampleBatch при заданных генераторе и rate
+bool check(const Case& c, RngEngine engine, std::optional<double> rate, size_t n, uint64_t seed) {
+    auto dist = c.make();
+    RandomGenerator scalarRng = RandomGenerator(seed, engine).stream(0);
+    RandomGenerator batchRng = RandomGenerator(seed, engine).stream(1);
+
+    std::vector<double> scalar(n), batch(n);
+    for (auto& x : scalar) x = dist->sample(scalarRng, rate);
+    // Пакетами разной длины: хвосты пакетов идут другим путём, чем основная часть
+    for (size_t done = 0, chunk = 1; done < n; done += chunk, chunk = chunk * 2 + 1) {
+        chunk = std::min(chunk, n - done);
+        dist->sampleBatch(batchRng, batch.data() + done, chunk, rate);
+    }
+
+    Moments m = moments(batch);
+    std::sort(scalar.begin(), scalar.end());
+    std::sort(batch.begin(), batch.end());
+    double d = ksStatistic(scalar, batch);
+    double p = ksPValue(d, n, n);
+    bool ok = p >= kMinPValue;
+
+    std::cout << std::left << std::setw(22) << c.name
+              << std::setw(9) << (engine == RngEngine::Philox4x32 ? "philox" : "xoshiro")
+              << std::setw(10) << (rate ? "rate=" + std::to_string(*rate).substr(0, 3) : std::string("-"))
+              << std::right << std::fixed << std::setprecision(5) << "D = " << d
+              << std::setprecision(4) << "  p = " << p;
+
+    // Моменты известны только без rate: rate меняет параметры по-своему у каждого распределения
+    if (!rate) {
+        double zMean = (m.mean - dist->mean()) / std::sqrt(dist->variance() / n);
+        double varianceError = std::sqrt(std::max(m.fourth - m.variance * m.variance, 0.0) / n);
+        double zVariance = varianceError > 0.0 ? (m.variance - dist->variance()) / varianceError : 0.0;
+        ok = ok && std::abs(zMean) <= kMaxMomentZ && std::abs(zVariance) <= kMaxMomentZ;
+        std::cout << std::setprecision(2) << "  z(mean) = " << std::showpos << zMean
+                  << "  z(var) = " << zVariance << std::noshowpos;
+    }
+    std::cout << (ok ? "  ok" : "  FAIL") << "\n";
+    std::cout.unsetf(std::ios::floatfield);
+    return ok;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    size_t samples = 200000;
+    uint64_t seed = 20240917;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--samples" && i + 1 < argc) {
+            samples = std::stoull(argv[++i]);
+        } else if (arg == "--seed" && i + 1 < argc) {
+            seed = std::stoull(argv[++i]);
+        } else {
+            std::cerr << "Usage: distribution_check [--samples N] [--seed S]\n";
+            return 2;
+        }
+    }
+    if (samples < 2) {
+        std::cerr << "Error: --samples must be at least 2\n";
+        return 2;
+    }
+
+    const std::vector<Case> cases = {
+        {"exp(2)",             [] { return DistributionFactory::exponential(2.0); }},
+        {"norm(5,1)",          [] { return DistributionFactory::normal(5.0, 1.0); }},
+        {"gamma(0.5,2)",       [] { return DistributionFactory::gamma(0.5, 2.0); }},
+        {"gamma(3,0.5)",       [] { return DistributionFactory::gamma(3.0, 0.5); }},
+        {"lognorm(0,0.5)",     [] { return DistributionFactory::lognormal(0.0, 0.5); }},
+        {"unif(1,3)",          [] { return DistributionFactory::uniform(1.0, 3.0); }},
+    };
+
+    int failures = 0;
+    for (const auto& c : cases)
+        for (RngEngine engine : {RngEngine::Xoshiro256pp, RngEngine::Philox4x32})
+            for (std::optional<double> rate : {std::optional<double>(), std::optional<double>(2.5)})
+                if (!check(c, engine, rate, samples, seed)) ++failures;
+
+    std::cout << (failures ? std::to_string(failures) + " check(s) failed" : std::string("All checks passed"))
+              << " (" << samples << " samples each, KS p >= " << kMinPValue
+              << ", |z| <= " << kMaxMomentZ << ")\n";
+    return failures ? 1 : 0;
+}
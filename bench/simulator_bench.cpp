@@ -0,0 +1,292 @@
+// simulator_bench.cpp — микробенчмарки горячих путей симулятора
+//
+// Usage: simulator_bench [--out FILE] [--quick] [--filter SUBSTR]
+//                        [--min-time SEC] [--repetitions R]
+//
+// Результаты пишутся в JSON (по умолчанию stdout); два файла сравнивает
+// bench/compare.py.
+#include "Simulator.h"
+#include "EventQueue.h"
+#include "Distribution.h"
+#include "RandomGenerator.h"
+#include "CliUtils.h"
+#include "Degradation.h"
+
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <functional>
+#include <algorithm>
+
+namespace {
+
+struct Options {
+    std::string out;
+    std::string filter;
+    bool quick = false;
+    double minTime = 0.2;   // минимальная длительность одного замера, сек
+    int repetitions = 3;    // замеров на бенчмарк; в отчёт идёт лучший
+};
+
+struct Result {
+    std::string name;
+    std::string unit;
+    double value;
+    bool higherIsBetter;
+};
+
+// Не даёт компилятору выбросить вычисления
+volatile double g_sink = 0.0;
+
+double seconds(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Выполняет body(iterations) пакетами, пока замер не займёт minTime;
+// возвращает лучшее время на одну итерацию (нс) из repetitions замеров
+double measureNsPerOp(const Options& opt, const std::function<void(uint64_t)>& body) {
+    uint64_t iterations = 1;
+    while (true) {
+        auto start = std::chrono::steady_clock::now();
+        body(iterations);
+        if (seconds(start) >= opt.minTime / 4 || iterations >= (uint64_t(1) << 40)) break;
+        iterations *= 4;
+    }
+    double best = INFINITY;
+    for (int r = 0; r < opt.repetitions; ++r) {
+        auto start = std::chrono::steady_clock::now();
+        body(iterations);
+        best = std::min(best, seconds(start) * 1e9 / static_cast<double>(iterations));
+    }
+    return best;
+}
+
+class Runner {
+    Options m_opt;
+    std::vector<Result> m_results;
+
+public:
+    explicit Runner(Options opt) : m_opt(std::move(opt)) {}
+
+    const Options& options() const { return m_opt; }
+    bool enabled(const std::string& name) const {
+        return m_opt.filter.empty() || name.find(m_opt.filter) != std::string::npos;
+    }
+
+    void report(const std::string& name, const std::string& unit, double value, bool higherIsBetter) {
+        m_results.push_back({name, unit, value, higherIsBetter});
+        std::cerr << std::left << std::setw(48) << name << std::right << std::fixed
+                  << std::setprecision(2) << std::setw(14) << value << " " << unit << "\n";
+    }
+
+    void nsPerOp(const std::string& name, const std::function<void(uint64_t)>& body) {
+        if (!enabled(name)) return;
+        report(name, "ns/op", measureNsPerOp(m_opt, body), false);
+    }
+
+    void writeJson(std::ostream& out) const {
+        out << "{\n  \"benchmarks\": [\n";
+        for (size_t i = 0; i < m_results.size(); ++i) {
+            const auto& r = m_results[i];
+            out << "    {\"name\": \"" << r.name << "\", \"unit\": \"" << r.unit
+                << "\", \"value\": " << std::setprecision(6) << std::scientific << r.value
+                << ", \"higher_is_better\": " << (r.higherIsBetter ? "true" : "false") << "}"
+                << (i + 1 < m_results.size() ? "," : "") << "\n";
+        }
+        out << "  ]\n}\n";
+    }
+};
+
+// === EventQueue: заполнение, «hold» (pop + push) и перенос ===
+void benchEventQueue(Runner& runner) {
+    const int maxExponent = runner.options().quick ? 5 : 7;
+    for (int e = 2; e <= maxExponent; ++e) {
+        int n = 1;
+        for (int i = 0; i < e; ++i) n *= 10;
+        const std::string suffix = "/n=1e" + std::to_string(e);
+
+        RandomGenerator rng(1);
+        EventQueue queue(n);
+        for (int u = 0; u < n; ++u) queue.push(rng.exponential(1.0), EventType::ACTIVATION, u, 0);
+
+        runner.nsPerOp("event_queue/push_replace" + suffix, [&](uint64_t iterations) {
+            for (uint64_t i = 0; i < iterations; ++i) {
+                int u = static_cast<int>(i % static_cast<uint64_t>(n));
+                queue.push(rng.exponential(1.0), EventType::ACTIVATION, u, 0);
+            }
+        });
+
+        // Модель hold: извлечь минимум и запланировать того же пользователя позже
+        runner.nsPerOp("event_queue/hold" + suffix, [&](uint64_t iterations) {
+            for (uint64_t i = 0; i < iterations; ++i) {
+                Event event = queue.pop();
+                queue.push(event.time + rng.exponential(1.0), event.type(), event.userId, 0);
+            }
+        });
+
+        runner.nsPerOp("event_queue/reschedule" + suffix, [&](uint64_t iterations) {
+            for (uint64_t i = 0; i < iterations; ++i) {
+                int u = static_cast<int>(rng.integer(0, n - 1));
+                queue.reschedule(u, queue.scheduledTime(u) * 1.0001);
+            }
+        });
+    }
+}
+
+// === Distribution: sample (по одной) и next (через пакетный буфер) ===
+void benchDistributions(Runner& runner) {
+    const char* specs[] = {"exp:1.0", "norm:5,1", "gamma:2,0.5", "lognorm:0,1", "det:1.0", "unif:1,3"};
+    for (const char* spec : specs) {
+        auto dist = Cli::createDist(Cli::parseDist(spec));
+        std::string type = Cli::parseDist(spec).type;
+        RandomGenerator rng(7);
+
+        runner.nsPerOp("distribution/sample/" + type, [&](uint64_t iterations) {
+            double sum = 0.0;
+            for (uint64_t i = 0; i < iterations; ++i) sum += dist->sample(rng);
+            g_sink = sum;
+        });
+        runner.nsPerOp("distribution/next/" + type, [&](uint64_t iterations) {
+            double sum = 0.0;
+            for (uint64_t i = 0; i < iterations; ++i) sum += dist->next(rng);
+            g_sink = sum;
+        });
+    }
+}
+
+// === Функции деградации: std::function и прямой вызов ядра ===
+void benchDegradation(Runner& runner) {
+    const char* specs[] = {"hyp:10", "exp:0.05", "lin:50", "thr:5,0.2"};
+    for (const char* spec : specs) {
+        std::string type = Cli::split(spec, ':')[0];
+        auto fn = parseDegradationFn(spec);
+        auto kernel = parseDegradation(spec);
+
+        runner.nsPerOp("degradation/function/" + type, [&](uint64_t iterations) {
+            double sum = 0.0, r = 0.0;
+            for (uint64_t i = 0; i < iterations; ++i) {
+                sum += fn(r);
+                r = r < 100.0 ? r + 0.37 : 0.0;
+            }
+            g_sink = sum;
+        });
+        std::visit([&](auto k) {
+            runner.nsPerOp("degradation/kernel/" + type, [&](uint64_t iterations) {
+                double sum = 0.0, r = 0.0;
+                for (uint64_t i = 0; i < iterations; ++i) {
+                    sum += k(r);
+                    r = r < 100.0 ? r + 0.37 : 0.0;
+                }
+                g_sink = sum;
+            });
+        }, kernel);
+    }
+}
+
+// === Сквозной прогон: событий в секунду ===
+template <class Sim>
+double eventsPerSecond(Sim& sim, double simTime) {
+    auto start = std::chrono::steady_clock::now();
+    sim.runUntil(simTime);
+    double elapsed = seconds(start);
+    return sim.getStats().totalEventsProcessed / elapsed;
+}
+
+void benchEndToEnd(Runner& runner) {
+    const int maxExponent = runner.options().quick ? 4 : 6;
+    const double eventBudget = runner.options().quick ? 2e5 : 2e6;
+    for (int e = 1; e <= maxExponent; ++e) {
+        int users = 1;
+        for (int i = 0; i < e; ++i) users *= 10;
+        for (EngineMode mode : {EngineMode::Rescale, EngineMode::VirtualTime, EngineMode::Lumped}) {
+            // Перемасштабирование — O(N) на событие: большие N не измеряем,
+            // а для остальных бюджет событий уменьшается пропорционально N
+            if (mode == EngineMode::Rescale && users > 10000) continue;
+            double budget = mode == EngineMode::Rescale ? eventBudget / std::max(1, users / 100) : eventBudget;
+            // Пользователь проходит цикл простоя (E=2) и обслуживания (~1): ~0.7 события/сек
+            double simTime = std::max(2.0, budget / (0.7 * users));
+            const std::string engine = mode == EngineMode::Rescale ? "rescale"
+                                     : mode == EngineMode::VirtualTime ? "vtime" : "lumped";
+            const std::string suffix = engine + "/users=1e" + std::to_string(e);
+
+            std::string name = "run_until/exponential/" + suffix;
+            if (runner.enabled(name)) {
+                double best = 0.0;
+                double bytesPerUser = 0.0;
+                for (int r = 0; r < runner.options().repetitions; ++r) {
+                    ExponentialSimulator<HyperbolicDegradation> sim(
+                        users, 1.0,
+                        std::make_unique<ExponentialDist>(1.0),
+                        std::make_unique<ExponentialDist>(0.5),
+                        std::make_unique<ExponentialDist>(1.0),
+                        HyperbolicDegradation{10.0},
+                        RandomGenerator(42));
+                    sim.setEngineMode(mode);
+                    best = std::max(best, eventsPerSecond(sim, simTime));
+                    bytesPerUser = static_cast<double>(sim.stateBytes()) / users;
+                }
+                runner.report(name, "events/s", best, true);
+                // Память под состояние, растущее с N (после прогона, с учётом учёта по пользователям)
+                runner.report("state_bytes/exponential/" + suffix, "bytes/user", bytesPerUser, false);
+            }
+
+            name = "run_until/generic/" + suffix;
+            if (runner.enabled(name)) {
+                double best = 0.0;
+                for (int r = 0; r < runner.options().repetitions; ++r) {
+                    Simulator sim(
+                        users, 1.0,
+                        Cli::createDist(Cli::parseDist("gamma:2,0.5")),
+                        Cli::createDist(Cli::parseDist("exp:0.5")),
+                        Cli::createDist(Cli::parseDist("exp:1.0")),
+                        parseDegradationFn("hyp:10"),
+                        RandomGenerator(42));
+                    sim.setEngineMode(mode);
+                    best = std::max(best, eventsPerSecond(sim, simTime));
+                }
+                runner.report(name, "events/s", best, true);
+            }
+        }
+    }
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Options opt;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--out" && i + 1 < argc) opt.out = argv[++i];
+        else if (arg == "--filter" && i + 1 < argc) opt.filter = argv[++i];
+        else if (arg == "--min-time" && i + 1 < argc) opt.minTime = std::stod(argv[++i]);
+        else if (arg == "--repetitions" && i + 1 < argc) opt.repetitions = std::max(1, std::stoi(argv[++i]));
+        else if (arg == "--quick") opt.quick = true;
+        else {
+            std::cerr << "Usage: simulator_bench [--out FILE] [--quick] [--filter SUBSTR]\n"
+                      << "                       [--min-time SEC] [--repetitions R]\n";
+            return arg == "--help" || arg == "-h" ? 0 : 1;
+        }
+    }
+
+    Runner runner(opt);
+    benchEventQueue(runner);
+    benchDistributions(runner);
+    benchDegradation(runner);
+    benchEndToEnd(runner);
+
+    if (opt.out.empty()) {
+        runner.writeJson(std::cout);
+    } else {
+        std::ofstream out(opt.out);
+        if (!out) {
+            std::cerr << "Error: cannot open " << opt.out << "\n";
+            return 1;
+        }
+        runner.writeJson(out);
+    }
+    return 0;
+}
@@ -0,0 +1,232 @@
+#include "Analytic.h"
+#include "ThreadPool.h"
+
+#include <vector>
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+namespace Analytic {
+namespace {
+
+// Предел размера цепи: при ~20 переходах на состояние это ~1 ГБ
+constexpr double kMaxStates = 4e6;
+constexpr double kTolerance = 1e-11;
+constexpr int kMaxIterations = 100000;
+
+// Разбиения total пользователей на parts фаз (композиции с нулями).
+// Номер композиции в лексикографическом порядке считается по биномиальным
+// коэффициентам: состояния не хранятся, соседи находятся за O(parts)
+class CompositionIndex {
+    int m_total;
+    int m_parts;
+    std::vector<std::vector<uint64_t>> m_binom;  // C(n, r), r ≤ parts
+
+public:
+    CompositionIndex(int total, int parts) : m_total(total), m_parts(parts) {
+        m_binom.assign(total + parts + 1, std::vector<uint64_t>(parts + 1, 0));
+        for (int n = 0; n <= total + parts; ++n) {
+            m_binom[n][0] = 1;
+            for (int r = 1; r <= std::min(n, parts); ++r)
+                m_binom[n][r] = m_binom[n - 1][r - 1] + (r <= n - 1 ? m_binom[n - 1][r] : 0);
+        }
+    }
+
+    // Число композиций без построения таблицы (для проверки предела)
+    static double countEstimate(int total, int parts) {
+        double count = 1.0;
+        for (int r = 1; r < parts; ++r) count = count * (total + r) / r;
+        return count;
+    }
+
+    uint64_t binom(int n, int r) const {
+        if (n < 0 || r < 0 || r > n) return 0;
+        return m_binom[n][r];
+    }
+
+    uint64_t count() const { return binom(m_total + m_parts - 1, m_parts - 1); }
+
+    // Σ по частям числа композиций, у которых префикс совпадает, а текущая
+    // часть меньше (тождество «хоккейной клюшки» сворачивает сумму по значениям)
+    uint64_t rank(const std::vector<int>& c) const {
+        uint64_t result = 0;
+        int remaining = m_total;
+        for (int i = 0; i + 1 < m_parts; ++i) {
+            int after = m_parts - 1 - i;
+            result += binom(remaining + after, after) - binom(remaining - c[i] + after, after);
+            remaining -= c[i];
+        }
+        return result;
+    }
+
+    // Следующая композиция в лексикографическом порядке; false после последней
+    bool next(std::vector<int>& c) const {
+        int tail = c[m_parts - 1];
+        for (int i = m_parts - 2; i >= 0; --i) {
+            if (tail > 0) {
+                c[i]++;
+                for (int j = i + 1; j < m_parts - 1; ++j) c[j] = 0;
+                c[m_parts - 1] = tail - 1;
+                return true;
+            }
+            tail += c[i];
+        }
+        return false;
+    }
+};
+
+struct Transition {
+    uint32_t from;
+    double rate;
+};
+
+} // namespace
+
+// Состояние — вектор (a_1..a_p, b_11..b_qL): сколько простаивающих
+// пользователей в каждой фазе простоя и активных — в каждой фазе
+// обслуживания с объёмом работы каждого из L классов; Σ = N. Активный
+// пользователь сохраняет класс до завершения, R = Σ b_jc·w_c. Пользователи
+// неразличимы, поэтому вместо (p+qL)^N состояний остаётся C(N+p+qL−1, p+qL−1).
+//
+// π·Q = 0 решается блочным Гауссом–Зейделем: состояния делятся на
+// непрерывные блоки, блоки обновляются параллельно; внутри блока
+// используются уже обновлённые значения, между блоками — значения
+// предыдущей итерации (гибрид Якоби и Гаусса–Зейделя без гонок данных).
+Result solveLumped(const Model& model, unsigned threads) {
+    const PhaseTypeDist& passive = model.passive;
+    const PhaseTypeDist& service = model.service;
+    const int n = model.users;
+    const std::vector<double> classes = model.workloadClasses.empty()
+        ? std::vector<double>{model.workloadMean} : model.workloadClasses;
+    const int p = static_cast<int>(passive.phases());
+    const int q = static_cast<int>(service.phases());
+    const int levels = static_cast<int>(classes.size());
+    const int parts = p + q * levels;
+    auto activePart = [&](int phase, int level) { return p + phase * levels + level; };
+
+    double estimate = CompositionIndex::countEstimate(n, parts);
+    if (estimate > kMaxStates) {
+        throw std::invalid_argument("Phase-type chain has " + std::to_string(static_cast<uint64_t>(estimate))
+                                    + " states (limit " + std::to_string(static_cast<uint64_t>(kMaxStates))
+                                    + "); reduce --analytic-phases/--analytic-classes or use simulation");
+    }
+    CompositionIndex index(n, parts);
+    const size_t states = index.count();
+
+    const double classProbability = 1.0 / levels;
+
+    // Переходы из состояния c: visit(откуда, куда, интенсивность)
+    auto forEachTransition = [&](const std::vector<int>& c, uint32_t from, auto&& visit) {
+        double workload = 0.0;
+        for (int j = 0; j < q; ++j)
+            for (int l = 0; l < levels; ++l) workload += c[activePart(j, l)] * classes[l];
+        double serviceRate = model.baseRate * model.degradation(workload);
+        if (!(serviceRate > 0.0))
+            throw std::invalid_argument("Degradation function reaches zero: the chain has no stationary distribution");
+        std::vector<int> target = c;
+        auto move = [&](int src, int dst, double rate) {
+            if (rate <= 0.0 || src == dst) return;
+            target[src]--;
+            target[dst]++;
+            visit(from, static_cast<uint32_t>(index.rank(target)), rate);
+            target[src]++;
+            target[dst]--;
+        };
+        for (int i = 0; i < p; ++i) {
+            if (c[i] == 0) continue;
+            double out = c[i] * passive.rate(i);
+            for (int j = 0; j < p; ++j) move(i, j, out * passive.transition(i, j));
+            double exit = out * passive.exitProbability(i) * classProbability;
+            for (int j = 0; j < q; ++j)
+                for (int l = 0; l < levels; ++l) move(i, activePart(j, l), exit * service.initialProbability(j));
+        }
+        for (int j = 0; j < q; ++j) {
+            for (int l = 0; l < levels; ++l) {
+                int part = activePart(j, l);
+                if (c[part] == 0) continue;
+                double out = c[part] * service.rate(j) * serviceRate;
+                for (int k = 0; k < q; ++k) move(part, activePart(k, l), out * service.transition(j, k));
+                double exit = out * service.exitProbability(j);
+                for (int i = 0; i < p; ++i) move(part, i, exit * passive.initialProbability(i));
+            }
+        }
+    };
+
+    // Входящие переходы в формате CSR: два прохода — подсчёт и заполнение
+    std::vector<size_t> incomingStart(states + 1, 0);
+    std::vector<double> outflow(states, 0.0);
+    std::vector<int> c(parts, 0);
+    c[parts - 1] = n;
+    for (uint32_t s = 0; s < states; ++s, index.next(c)) {
+        forEachTransition(c, s, [&](uint32_t from, uint32_t to, double rate) {
+            incomingStart[to + 1]++;
+            outflow[from] += rate;
+        });
+    }
+    for (size_t s = 0; s < states; ++s) incomingStart[s + 1] += incomingStart[s];
+    std::vector<Transition> incoming(incomingStart[states]);
+    std::vector<size_t> fill(incomingStart.begin(), incomingStart.end() - 1);
+    std::fill(c.begin(), c.end(), 0);
+    c[parts - 1] = n;
+    for (uint32_t s = 0; s < states; ++s, index.next(c)) {
+        forEachTransition(c, s, [&](uint32_t from, uint32_t to, double rate) {
+            incoming[fill[to]++] = {from, rate};
+        });
+    }
+
+    // Итерации: π_s = Σ π_t·q(t,s) / q_s
+    const size_t blocks = std::min<size_t>(states, std::max(1u, threads) * 8);
+    const size_t blockSize = (states + blocks - 1) / blocks;
+    std::vector<double> prev(states, 1.0 / states);
+    std::vector<double> next(states);
+    int iteration = 0;
+    for (;;) {
+        if (++iteration > kMaxIterations)
+            throw std::runtime_error("Phase-type chain did not converge in " + std::to_string(kMaxIterations) + " iterations");
+        next = prev;
+        Parallel::forEach(blocks, threads, [&](size_t b) {
+            size_t lo = b * blockSize;
+            size_t hi = std::min(states, lo + blockSize);
+            for (size_t s = lo; s < hi; ++s) {
+                double sum = 0.0;
+                for (size_t e = incomingStart[s]; e < incomingStart[s + 1]; ++e) {
+                    size_t t = incoming[e].from;
+                    sum += (t >= lo && t < hi ? next[t] : prev[t]) * incoming[e].rate;
+                }
+                next[s] = outflow[s] > 0.0 ? sum / outflow[s] : next[s];
+            }
+        });
+
+        double norm = 0.0, peak = 0.0;
+        for (double v : next) norm += v;
+        for (double& v : next) {
+            v /= norm;
+            peak = std::max(peak, v);
+        }
+        double change = 0.0;
+        for (size_t s = 0; s < states; ++s) change = std::max(change, std::abs(next[s] - prev[s]));
+        prev.swap(next);
+        if (change <= kTolerance * peak) break;
+    }
+
+    Result result;
+    result.pk.assign(n + 1, 0.0);
+    std::fill(c.begin(), c.end(), 0);
+    c[parts - 1] = n;
+    for (size_t s = 0; s < states; ++s, index.next(c)) {
+        int active = 0;
+        for (int part = p; part < parts; ++part) active += c[part];
+        result.pk[active] += prev[s];
+        for (int i = 0; i < p; ++i) result.throughput += prev[s] * c[i] * passive.rate(i) * passive.exitProbability(i);
+    }
+    for (int k = 0; k <= n; ++k) result.meanActive += k * result.pk[k];
+    result.meanResponse = result.throughput > 0.0 ? result.meanActive / result.throughput : 0.0;
+    result.exact = model.exactWorkload && model.exactPhases;
+    result.states = states;
+    result.iterations = iteration;
+    return result;
+}
+
+} // namespace Analytic
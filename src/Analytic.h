@@ -0,0 +1,153 @@
+// === Analytic.h ===
+#pragma once
+#include "Simulator.h"
+
+#include <vector>
+#include <functional>
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <iostream>
+#include <iomanip>
+
+// Аналитическое решение замкнутой модели.
+//
+// Время обслуживания в симуляторе выбирается при текущей эффективной
+// скорости узла и перемасштабируется при её изменении, то есть требование
+// обслуживания S (в единицах при скорости 1) расходуется со скоростью
+// μ(R) = μ₀·f(R), где R — суммарный объём работы активных.
+//
+// Экспоненциальные простой (λ) и S: цепь рождения–гибели по числу активных
+// k = 0..N, рождение (N−k)·λ, гибель k·μ₀·f(R_k).
+// Иначе простой и S приближаются фазовыми распределениями, и решается
+// цепь по числу пользователей в каждой фазе (пользователи симметричны,
+// поэтому их состояния агрегируются — см. solveLumped).
+//
+// При детерминированном объёме работы R_k = k·w. Иначе R при данном k
+// случайно: при одном классе берётся R_k = k·E[W] (приближение среднего
+// поля), а при нескольких классах объёма работы (равновероятные группы
+// значений W) активные пользователи учитываются по классам и R считается
+// точно для дискретизированного W. Отличие от симуляции показывает --validate.
+namespace Analytic {
+
+struct Model {
+    int users = 0;
+    PhaseTypeDist passive = PhaseTypeDist::fitMoments(1.0, 1.0); // время простоя
+    PhaseTypeDist service = PhaseTypeDist::fitMoments(1.0, 1.0); // требование S при скорости 1
+    double baseRate = 0.0;                     // μ₀
+    double workloadMean = 0.0;                 // E[W]
+    std::vector<double> workloadClasses;       // значения W равновероятных классов (пусто — E[W])
+    bool exactWorkload = false;                // объём работы детерминирован
+    bool exactPhases = false;                  // простой и S заданы фазовыми/экспонентой, не подобраны
+    std::function<double(double)> degradation; // f(R)
+};
+
+struct Result {
+    std::vector<double> pk;   // стационарное P(k)
+    double meanActive = 0.0;  // E[k]
+    double throughput = 0.0;  // завершений в секунду: E[(N−k)·λ]
+    double meanResponse = 0.0;// по формуле Литтла: E[k] / throughput
+    bool exact = false;
+    size_t states = 0;        // размер решённой цепи
+    int iterations = 0;       // итерации Гаусса–Зейделя (0 — решение в явном виде)
+
+    double utilization(int users) const { return users > 0 ? meanActive / users : 0.0; }
+};
+
+// Цепь по числу пользователей в каждой фазе простоя и в каждой паре
+// (фаза обслуживания, класс объёма работы); параллельный блочный
+// Гаусс–Зейдель (Analytic.cpp)
+Result solveLumped(const Model& model, unsigned threads);
+
+// Стационарное распределение из уравнений баланса π_k·μ_k = π_{k−1}·λ_{k−1};
+// считается в логарифмах, чтобы не переполняться при больших N. O(N)
+inline Result solveBirthDeath(const Model& model) {
+    const int n = model.users;
+    const double passiveRate = model.passive.rate(0);
+    const double serviceRate = model.service.rate(0);
+    std::vector<double> logPi(n + 1, 0.0);
+    for (int k = 1; k <= n; ++k) {
+        double birth = (n - k + 1) * passiveRate;
+        double death = k * serviceRate * model.baseRate * model.degradation(k * model.workloadMean);
+        if (!(death > 0.0))
+            throw std::invalid_argument("Degradation function reaches zero: the chain has no stationary distribution");
+        logPi[k] = logPi[k - 1] + std::log(birth) - std::log(death);
+    }
+
+    double maxLog = *std::max_element(logPi.begin(), logPi.end());
+    Result result;
+    result.pk.resize(n + 1);
+    double norm = 0.0;
+    for (int k = 0; k <= n; ++k) {
+        result.pk[k] = std::exp(logPi[k] - maxLog);
+        norm += result.pk[k];
+    }
+    for (int k = 0; k <= n; ++k) {
+        result.pk[k] /= norm;
+        result.meanActive += k * result.pk[k];
+    }
+
+    result.throughput = (n - result.meanActive) * passiveRate;
+    result.meanResponse = result.throughput > 0.0 ? result.meanActive / result.throughput : 0.0;
+    result.exact = model.exactWorkload && model.exactPhases;
+    result.states = static_cast<size_t>(n) + 1;
+    return result;
+}
+
+inline Result solve(const Model& model, unsigned threads = 1) {
+    if (model.users <= 0) throw std::invalid_argument("Analytic model needs users > 0");
+    if (model.baseRate <= 0.0) throw std::invalid_argument("Analytic model needs a positive base rate");
+    if (model.passive.phases() == 1 && model.service.phases() == 1 && model.workloadClasses.size() <= 1)
+        return solveBirthDeath(model);
+    return solveLumped(model, threads);
+}
+
+// Сводка в формате SimulationStats::printSummary; накопленные за прогон
+// величины приводятся к длительности simTime
+inline void printSummary(const Result& result, int users, double simTime) {
+    double utilization = result.utilization(users);
+    std::cout << "\n=== Аналитическое решение (CTMC) ===\n";
+    std::cout << "Метод:                  "
+              << (result.iterations == 0 ? "цепь рождения–гибели" : "фазовая цепь, Гаусс–Зейдель")
+              << ", " << result.states << " состояний"
+              << (result.iterations > 0 ? ", " + std::to_string(result.iterations) + " итераций" : "")
+              << ", " << (result.exact ? "точно" : "приближённо") << "\n";
+    std::cout << "Время симуляции:        " << std::fixed << std::setprecision(2)
+              << simTime << " сек (эквивалент)\n";
+    std::cout << "Число пользователей:    " << users << "\n";
+    std::cout << "Загрузка узла (ρ):      " << std::fixed << std::setprecision(4)
+              << utilization << " (" << utilization * 100 << "%)\n";
+    std::cout << "Среднее время активности: " << std::fixed << std::setprecision(3)
+              << simTime * utilization << " сек\n";
+    std::cout << "Среднее время простоя:  " << std::fixed << std::setprecision(3)
+              << simTime * (1.0 - utilization) << " сек\n";
+    std::cout << "Среднее число задач:    " << std::fixed << std::setprecision(1)
+              << simTime * result.throughput / users << "\n";
+    std::cout << "Время отклика: среднее " << std::fixed << std::setprecision(3)
+              << result.meanResponse << " сек (формула Литтла)\n";
+    std::cout << "============================\n";
+    SimulationStats::printDistribution(result.pk);
+}
+
+// Расхождение симуляции с аналитикой: max |ΔP(k)| и разница загрузок
+inline void printValidation(const Result& result, const SimulationStats& stats, int users) {
+    auto pk = stats.getProbabilityDistribution();
+    double maxDiff = 0.0;
+    size_t argMax = 0;
+    for (size_t k = 0; k < pk.size() && k < result.pk.size(); ++k) {
+        double diff = std::abs(pk[k] - result.pk[k]);
+        if (diff > maxDiff) {
+            maxDiff = diff;
+            argMax = k;
+        }
+    }
+    std::cout << "\n=== Сверка с аналитическим решением ("
+              << (result.exact ? "точное" : "приближённое") << ") ===\n";
+    std::cout << "max |ΔP(k)|:            " << std::scientific << std::setprecision(3)
+              << maxDiff << " (k = " << argMax << ")\n";
+    std::cout << "Загрузка ρ: симуляция " << std::fixed << std::setprecision(4)
+              << stats.getNodeUtilization(users) << ", аналитика " << result.utilization(users) << "\n";
+    std::cout << "============================\n";
+}
+
+} // namespace Analytic
@@ -0,0 +1,117 @@
+// === AsyncListener.h ===
+#pragma once
+#include "ISimulationListener.h"
+#include "SpscRing.h"
+
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+// Что делать со снимком, если очередь полна
+enum class OverflowPolicy {
+    Block,  // ждать читателя: ни один снимок не теряется
+    Drop    // отбросить снимок и учесть в счётчике: цикл событий не ждёт
+};
+
+// Декоратор слушателя: onSnapshot только кладёт снимок в кольцевую очередь,
+// а форматирование и вывод внутреннего слушателя выполняет фоновый поток.
+// Окна агрегации идут через ту же очередь, порядок вызовов сохраняется.
+// onSimulationEnd дожидается, пока очередь опустеет, и завершает внутренний
+// слушатель; счётчики после этого окончательны.
+class AsyncListener : public ISimulationListener {
+    struct Item {
+        bool isWindow;
+        SimulationSnapshot snapshot;
+        WindowSummary window;
+    };
+
+    std::unique_ptr<ISimulationListener> m_inner;
+    OverflowPolicy m_policy;
+    SpscRing<Item> m_ring;
+    std::atomic<bool> m_stop{false};
+    std::thread m_consumer;
+
+    // Счётчики писателя (поток симуляции)
+    uint64_t m_pushed = 0;
+    uint64_t m_dropped = 0;
+    size_t m_maxDepth = 0;
+
+    void deliver(const Item& item) {
+        if (item.isWindow) {
+            m_inner->onWindow(item.window);
+        } else {
+            m_inner->onSnapshot(item.snapshot);
+        }
+    }
+
+    void consume() {
+        Item item;
+        int idle = 0;
+        while (true) {
+            if (m_ring.tryPop(item)) {
+                deliver(item);
+                idle = 0;
+            } else if (m_stop.load(std::memory_order_acquire)) {
+                while (m_ring.tryPop(item)) deliver(item);
+                return;
+            } else if (++idle < 64) {
+                std::this_thread::yield();
+            } else {
+                std::this_thread::sleep_for(std::chrono::microseconds(100));
+            }
+        }
+    }
+
+    void push(const Item& item) {
+        if (!m_ring.tryPush(item)) {
+            if (m_policy == OverflowPolicy::Drop) {
+                ++m_dropped;
+                return;
+            }
+            while (!m_ring.tryPush(item)) std::this_thread::yield();
+        }
+        ++m_pushed;
+        size_t depth = m_ring.sizeFromProducer();
+        if (depth > m_maxDepth) m_maxDepth = depth;
+    }
+
+    void stop() {
+        if (!m_consumer.joinable()) return;
+        m_stop.store(true, std::memory_order_release);
+        m_consumer.join();
+    }
+
+public:
+    AsyncListener(std::unique_ptr<ISimulationListener> inner,
+                  size_t capacity = 4096,
+                  OverflowPolicy policy = OverflowPolicy::Block)
+        : m_inner(std::move(inner)), m_policy(policy), m_ring(capacity) {
+        m_consumer = std::thread([this] { consume(); });
+    }
+
+    ~AsyncListener() override { stop(); }
+
+    AsyncListener(const AsyncListener&) = delete;
+    AsyncListener& operator=(const AsyncListener&) = delete;
+
+    void onSnapshot(const SimulationSnapshot& snapshot) override {
+        push({false, snapshot, {}});
+    }
+
+    void onWindow(const WindowSummary& window) override {
+        push({true, {}, window});
+    }
+
+    void onSimulationEnd() override {
+        stop();
+        m_inner->onSimulationEnd();
+    }
+
+    uint64_t delivered() const { return m_pushed; }
+    uint64_t dropped() const { return m_dropped; }
+    size_t maxDepth() const { return m_maxDepth; }
+    size_t capacity() const { return m_ring.capacity(); }
+};
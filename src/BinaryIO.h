@@ -0,0 +1,71 @@
+// === BinaryIO.h ===
+#pragma once
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <stdexcept>
+#include <type_traits>
+
+// Чтение/запись тривиально копируемых значений и векторов в бинарном виде
+// (порядок байт платформы). Используется контрольными точками симулятора.
+namespace BinaryIO {
+
+template <class T>
+void write(std::ostream& out, const T& value) {
+    static_assert(std::is_trivially_copyable<T>::value, "BinaryIO::write needs a POD");
+    out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <class T>
+T read(std::istream& in) {
+    static_assert(std::is_trivially_copyable<T>::value, "BinaryIO::read needs a POD");
+    T value;
+    if (!in.read(reinterpret_cast<char*>(&value), sizeof(T)))
+        throw std::runtime_error("Unexpected end of binary stream");
+    return value;
+}
+
+template <class T>
+void writeVector(std::ostream& out, const std::vector<T>& values) {
+    static_assert(std::is_trivially_copyable<T>::value, "BinaryIO::writeVector needs a POD");
+    write<uint64_t>(out, values.size());
+    if (!values.empty())
+        out.write(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(T));
+}
+
+template <class T>
+std::vector<T> readVector(std::istream& in) {
+    static_assert(std::is_trivially_copyable<T>::value, "BinaryIO::readVector needs a POD");
+    std::vector<T> values(read<uint64_t>(in));
+    if (!values.empty() && !in.read(reinterpret_cast<char*>(values.data()), values.size() * sizeof(T)))
+        throw std::runtime_error("Unexpected end of binary stream");
+    return values;
+}
+
+// std::vector<bool> упакован побитно — пишется по байту на элемент
+inline void writeBools(std::ostream& out, const std::vector<bool>& values) {
+    write<uint64_t>(out, values.size());
+    for (bool v : values) write<uint8_t>(out, v ? 1 : 0);
+}
+
+inline std::vector<bool> readBools(std::istream& in) {
+    std::vector<bool> values(read<uint64_t>(in));
+    for (size_t i = 0; i < values.size(); ++i) values[i] = read<uint8_t>(in) != 0;
+    return values;
+}
+
+inline void writeString(std::ostream& out, const std::string& s) {
+    write<uint64_t>(out, s.size());
+    out.write(s.data(), static_cast<std::streamsize>(s.size()));
+}
+
+inline std::string readString(std::istream& in) {
+    std::string s(read<uint64_t>(in), '\0');
+    if (!s.empty() && !in.read(&s[0], static_cast<std::streamsize>(s.size())))
+        throw std::runtime_error("Unexpected end of binary stream");
+    return s;
+}
+
+} // namespace BinaryIO
@@ -0,0 +1,85 @@
+// BinarySnapshotWriter.h
+#pragma once
+#include "ISimulationListener.h"
+#include "SnapshotFormat.h"
+
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Запись снимков в двоичный колоночный формат (см. SnapshotFormat.h).
+// Строки копятся в блоке и сбрасываются целиком: четыре непрерывные записи
+// колонок вместо форматирования каждой строки. baseRate — μ₀ симулятора:
+// по нему читатель восстанавливает degradation_factor.
+class BinarySnapshotWriter : public ISimulationListener {
+    std::unique_ptr<std::ofstream> m_file;
+    std::vector<char> m_streamBuffer;
+    uint32_t m_rowsPerBlock;
+    SnapshotFormat::Block m_block;
+    std::vector<SnapshotFormat::BlockInfo> m_index;
+    uint64_t m_totalRows = 0;
+
+    void flushBlock() {
+        if (m_block.size() == 0) return;
+        const uint32_t rows = static_cast<uint32_t>(m_block.size());
+        m_index.push_back({static_cast<uint64_t>(m_file->tellp()), rows,
+                           m_block.time.front(), m_block.time.back()});
+
+        SnapshotFormat::writeValue(*m_file, rows);
+        SnapshotFormat::writeArray(*m_file, m_block.time.data(), rows);
+        SnapshotFormat::writeArray(*m_file, m_block.activeUsers.data(), rows);
+        SnapshotFormat::writeArray(*m_file, m_block.totalWorkload.data(), rows);
+        SnapshotFormat::writeArray(*m_file, m_block.effectiveRate.data(), rows);
+        m_totalRows += rows;
+        m_block.clear();
+    }
+
+public:
+    BinarySnapshotWriter(const std::string& filename, double baseRate, uint32_t rowsPerBlock = 65536)
+        : m_streamBuffer(1 << 20), m_rowsPerBlock(rowsPerBlock) {
+        m_file = std::make_unique<std::ofstream>();
+        m_file->rdbuf()->pubsetbuf(m_streamBuffer.data(), static_cast<std::streamsize>(m_streamBuffer.size()));
+        m_file->open(filename, std::ios::binary | std::ios::trunc);
+        if (!m_file->is_open()) {
+            throw std::runtime_error("Cannot open snapshot file: " + filename);
+        }
+        m_block.reserve(m_rowsPerBlock);
+
+        // Заголовок; indexOffset и totalRows дописываются при закрытии
+        m_file->write(SnapshotFormat::kMagic, sizeof(SnapshotFormat::kMagic));
+        SnapshotFormat::writeValue(*m_file, SnapshotFormat::kVersion);
+        SnapshotFormat::writeValue(*m_file, SnapshotFormat::kColumns);
+        SnapshotFormat::writeValue(*m_file, m_rowsPerBlock);
+        SnapshotFormat::writeValue<uint32_t>(*m_file, 0);
+        SnapshotFormat::writeValue<uint64_t>(*m_file, 0);
+        SnapshotFormat::writeValue<uint64_t>(*m_file, 0);
+        SnapshotFormat::writeValue(*m_file, baseRate);
+    }
+
+    ~BinarySnapshotWriter() override { onSimulationEnd(); }
+
+    void onSnapshot(const SimulationSnapshot& snapshot) override {
+        m_block.append(snapshot);
+        if (m_block.size() >= m_rowsPerBlock) flushBlock();
+    }
+
+    void onSimulationEnd() override {
+        if (!m_file || !m_file->is_open()) return;
+        flushBlock();
+
+        uint64_t indexOffset = static_cast<uint64_t>(m_file->tellp());
+        SnapshotFormat::writeValue<uint64_t>(*m_file, m_index.size());
+        for (const auto& block : m_index) {
+            SnapshotFormat::writeValue(*m_file, block.offset);
+            SnapshotFormat::writeValue(*m_file, block.rows);
+            SnapshotFormat::writeValue(*m_file, block.firstTime);
+            SnapshotFormat::writeValue(*m_file, block.lastTime);
+        }
+
+        m_file->seekp(static_cast<std::streamoff>(SnapshotFormat::kIndexOffsetPosition));
+        SnapshotFormat::writeValue(*m_file, indexOffset);
+        SnapshotFormat::writeValue(*m_file, m_totalRows);
+        m_file->close();
+    }
+};
@@ -76,6 +76,11 @@ inline auto createDist(const DistConfig& cfg) {
             throw std::invalid_argument("uniform requires 2 params: min,max");
         return DistributionFactory::uniform(cfg.params[0], cfg.params[1]);
     }
+    if (cfg.type == "ph" || cfg.type == "phase") {
+        if (cfg.params.size() != 2) 
+            throw std::invalid_argument("phase-type requires 2 params: mean,scv");
+        return DistributionFactory::phaseType(cfg.params[0], cfg.params[1]);
+    }
     throw std::invalid_argument("Unknown distribution type: " + cfg.type);
 }
 
@@ -0,0 +1,303 @@
+// === Cluster.h ===
+#pragma once
+#include "Simulator.h"
+#include "Distribution.h"
+#include "EventQueue.h"
+#include "IRoutingPolicy.h"
+#include "RandomGenerator.h"
+#include "ThreadPool.h"
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <algorithm>
+#include <stdexcept>
+#include <iostream>
+#include <iomanip>
+
+// Кластер из нескольких узлов: параллельная дискретно-событийная симуляция
+// с консервативной синхронизацией по временным окнам (в духе YAWNS).
+//
+// Каждый узел — отдельный симулятор в режиме раздела (setPartitionMode)
+// со своей очередью событий и потоком ГСЧ. Простаивающие пользователи
+// живут в диспетчере: он разыгрывает время простоя и объём работы, в момент
+// активации t выбирает узел политикой маршрутизации и отправляет задачу,
+// которая приходит на узел в t + δ (задержка диспетчеризации). Задержка δ —
+// это lookahead: задача, отправленная в окне [T, T+W) при W ≤ δ, не может
+// прийти на узел раньше конца окна. Поэтому окно выполняется в две фазы:
+//   1) все узлы параллельно доходят до T+W (им уже известны все приходы
+//      до T+W);
+//   2) диспетчер в порядке времени обрабатывает уходы задач с узлов и
+//      активации до T+W, видя состояние каждого узла на момент активации
+//      по журналу его состояний за окно.
+// Узел хранит состояние не пользователей, а слотов задач: диспетчер выдаёт
+// задаче свободный слот узла (последний освобождённый или новый) и помнит,
+// чей он, поэтому память и обходы на узле растут с числом задач на нём,
+// а не со всеми пользователями кластера.
+// Окно отсчитывается от ближайшего запланированного события (нижняя граница
+// времени следующего события, как в YAWNS): раньше него новых приходов нет.
+// Синхронизация одна на окно (барьер вместо null-сообщений), а результат не
+// зависит ни от числа потоков, ни от ширины окна W ≤ δ: это та же
+// последовательная симуляция, только узлы внутри окна идут параллельно.
+template <class Sim>
+class Cluster {
+    // Задача в пути к узлу
+    struct InFlight {
+        double arrival;
+        double workload;
+    };
+
+    struct Node {
+        std::unique_ptr<Sim> sim;
+        NodeState state{0.0, 0, 0.0};   // состояние на момент, видимый диспетчеру
+        size_t logCursor = 0;           // первая ещё не учтённая запись журнала
+        std::deque<InFlight> inFlight;
+        double inFlightWorkload = 0.0;
+        uint64_t routed = 0;            // отправлено задач на узел
+        std::vector<int> slotUser;      // слот узла -> пользователь
+        std::vector<int> freeSlots;
+    };
+
+    // Уход задачи со слота узла
+    struct Return {
+        double time;
+        size_t node;
+        int slot;
+    };
+
+    int m_users;
+    std::vector<Node> m_nodes;
+    std::unique_ptr<Distribution> m_workloadDist;
+    std::unique_ptr<Distribution> m_passiveDist;
+    std::unique_ptr<IRoutingPolicy> m_routing;
+    double m_dispatchDelay;
+    double m_syncWindow;
+    RandomGenerator m_rng;
+
+    EventQueue m_idle;                  // простаивающие пользователи: время следующей активации
+    std::vector<Return> m_returns;      // уходы с узлов за окно, по времени
+    std::vector<NodeLoad> m_loads;
+    double m_currentTime = 0.0;
+    bool m_initialized = false;
+    uint64_t m_windows = 0;
+    uint64_t m_messages = 0;
+
+    void initialize() {
+        m_idle.reserve(m_users);
+        for (int userId = 0; userId < m_users; ++userId)
+            m_idle.push(m_passiveDist->sample(m_rng), EventType::ACTIVATION, userId, 0);
+        m_initialized = true;
+    }
+
+    // Загрузка узлов на момент time: записи журнала до time включительно
+    // и задачи, которые к time ещё не дошли
+    void observeLoads(double time) {
+        for (size_t j = 0; j < m_nodes.size(); ++j) {
+            Node& node = m_nodes[j];
+            const auto& log = node.sim->stateLog();
+            while (node.logCursor < log.size() && log[node.logCursor].time <= time)
+                node.state = log[node.logCursor++];
+            while (!node.inFlight.empty() && node.inFlight.front().arrival <= time) {
+                node.inFlightWorkload -= node.inFlight.front().workload;
+                node.inFlight.pop_front();
+            }
+            if (node.inFlight.empty()) node.inFlightWorkload = 0.0;
+            m_loads[j].tasks = node.state.activeCount + static_cast<int>(node.inFlight.size());
+            m_loads[j].workload = node.state.totalWorkload + node.inFlightWorkload;
+        }
+    }
+
+    void dispatch(double time, int userId) {
+        double workload = m_workloadDist->sample(m_rng);
+        observeLoads(time);
+        size_t j = m_routing->route(m_loads, workload, [this](size_t node, double totalWorkload) {
+            return m_nodes[node].sim->computeEffectiveRate(totalWorkload);
+        }, m_rng);
+        if (j >= m_nodes.size()) throw std::out_of_range("Routing policy returned a bad node index");
+        Node& node = m_nodes[j];
+        int slot = static_cast<int>(node.slotUser.size());
+        if (node.freeSlots.empty()) {
+            node.slotUser.push_back(userId);
+        } else {
+            slot = node.freeSlots.back();
+            node.freeSlots.pop_back();
+            node.slotUser[slot] = userId;
+        }
+        double arrival = time + m_dispatchDelay;
+        node.sim->injectArrival(arrival, slot, workload);
+        node.inFlight.push_back({arrival, workload});
+        node.inFlightWorkload += workload;
+        node.routed++;
+        m_messages++;
+    }
+
+    // Фаза 2: уходы и активации до windowEnd в порядке времени (уход раньше
+    // активации в тот же момент). Порядок обращений к ГСЧ диспетчера и
+    // освобождения слотов от границ окон не зависит
+    void runDispatcher(double windowEnd) {
+        m_returns.clear();
+        for (size_t j = 0; j < m_nodes.size(); ++j) {
+            auto& out = m_nodes[j].sim->departures();
+            for (const Departure& d : out) m_returns.push_back({d.time, j, d.slot});
+            out.clear();
+        }
+        std::stable_sort(m_returns.begin(), m_returns.end(),
+                         [](const Return& a, const Return& b) { return a.time < b.time; });
+
+        size_t next = 0;
+        for (;;) {
+            bool haveReturn = next < m_returns.size();
+            bool haveActivation = !m_idle.empty() && m_idle.peek().time < windowEnd;
+            if (haveReturn && (!haveActivation || m_returns[next].time <= m_idle.peek().time)) {
+                const Return& r = m_returns[next++];
+                Node& node = m_nodes[r.node];
+                node.freeSlots.push_back(r.slot);
+                m_idle.push(r.time + m_passiveDist->sample(m_rng), EventType::ACTIVATION, node.slotUser[r.slot], 0);
+            } else if (haveActivation) {
+                Event event = m_idle.pop();
+                dispatch(event.time, event.userId);
+            } else {
+                break;
+            }
+        }
+
+        for (auto& node : m_nodes) {
+            observeTail(node);
+            node.sim->stateLog().clear();
+            node.logCursor = 0;
+        }
+    }
+
+    // Состояние на конец окна становится исходным для следующего
+    static void observeTail(Node& node) {
+        const auto& log = node.sim->stateLog();
+        if (!log.empty()) node.state = log.back();
+    }
+
+public:
+    Cluster(int users,
+            std::vector<std::unique_ptr<Sim>> nodes,
+            std::unique_ptr<Distribution> workloadDist,
+            std::unique_ptr<Distribution> passiveDist,
+            std::unique_ptr<IRoutingPolicy> routing,
+            double dispatchDelay,
+            RandomGenerator rng)
+        : m_users(users),
+          m_workloadDist(std::move(workloadDist)),
+          m_passiveDist(std::move(passiveDist)),
+          m_routing(std::move(routing)),
+          m_dispatchDelay(dispatchDelay),
+          m_syncWindow(dispatchDelay),
+          m_rng(std::move(rng)) {
+        if (users <= 0) throw std::invalid_argument("Cluster needs users > 0");
+        if (nodes.empty()) throw std::invalid_argument("Cluster needs at least one node");
+        if (!(dispatchDelay > 0.0)) throw std::invalid_argument("Cluster needs a positive dispatch delay");
+        for (auto& sim : nodes) {
+            sim->setPerUserStats(false);
+            sim->setPartitionMode();
+            m_nodes.emplace_back();
+            m_nodes.back().sim = std::move(sim);
+        }
+        m_loads.resize(m_nodes.size());
+    }
+
+    // Ширина окна синхронизации: 0 < W ≤ δ (по умолчанию δ). Меньшее окно
+    // даёт тот же результат ценой большего числа барьеров
+    void setSyncWindow(double window) {
+        if (!(window > 0.0) || window > m_dispatchDelay)
+            throw std::invalid_argument("Sync window must be in (0, dispatch delay]");
+        m_syncWindow = window;
+    }
+
+    void runUntil(double endTime, unsigned threads) {
+        if (endTime < m_currentTime) throw std::invalid_argument("runUntil: endTime is before the current time");
+        if (!m_initialized) initialize();
+        Parallel::Team team(std::min<unsigned>(threads, static_cast<unsigned>(m_nodes.size())));
+        while (m_currentTime < endTime) {
+            // До ближайшего события ничего не происходит, поэтому окно
+            // начинается с него: пустые окна не стоят барьера
+            double next = m_idle.empty() ? endTime : m_idle.peek().time;
+            for (const auto& node : m_nodes) next = std::min(next, node.sim->nextEventTime());
+            double windowEnd = std::min(std::max(next, m_currentTime) + m_syncWindow, endTime);
+            team.forEach(m_nodes.size(), [&](size_t j) { m_nodes[j].sim->runUntil(windowEnd); });
+            runDispatcher(windowEnd);
+            m_currentTime = windowEnd;
+            m_windows++;
+        }
+    }
+
+    size_t nodeCount() const { return m_nodes.size(); }
+    const Sim& node(size_t j) const { return *m_nodes[j].sim; }
+    uint64_t windows() const { return m_windows; }
+    uint64_t messages() const { return m_messages; }
+
+    uint64_t eventsProcessed() const {
+        uint64_t events = 0;
+        for (const auto& node : m_nodes) events += node.sim->getStats().totalEventsProcessed;
+        return events;
+    }
+
+    // Время на узле (без δ) по всем узлам
+    LatencyQuantiles mergedCompletionTime() const {
+        LatencyQuantiles merged(m_nodes.front().sim->getStats().completionTime.method());
+        for (const auto& node : m_nodes) merged.merge(node.sim->getStats().completionTime);
+        return merged;
+    }
+
+    // P(k) на узле, усреднённое по узлам; обрезано по наибольшему k
+    std::vector<double> meanNodeDistribution() const {
+        int maxK = 0;
+        for (const auto& node : m_nodes) maxK = std::max(maxK, node.sim->getStats().maxConcurrentUsers);
+        std::vector<double> pk(maxK + 1, 0.0);
+        for (const auto& node : m_nodes) {
+            auto nodePk = node.sim->getStats().getProbabilityDistribution();
+            for (size_t k = 0; k < nodePk.size() && k < pk.size(); ++k) pk[k] += nodePk[k] / m_nodes.size();
+        }
+        return pk;
+    }
+
+    void printSummary() const {
+        double simTime = m_currentTime;
+        uint64_t completions = 0;
+        double activeSum = 0.0;
+        double minActive = 0.0, maxActive = 0.0;
+        for (size_t j = 0; j < m_nodes.size(); ++j) {
+            const auto& stats = m_nodes[j].sim->getStats();
+            completions += stats.completionTime.count();
+            double active = simTime > 0.0 ? stats.nodeBusyTime / simTime : 0.0;
+            activeSum += active;
+            minActive = j == 0 ? active : std::min(minActive, active);
+            maxActive = j == 0 ? active : std::max(maxActive, active);
+        }
+        double throughput = simTime > 0.0 ? completions / simTime : 0.0;
+        double inFlight = throughput * m_dispatchDelay;  // формула Литтла
+        auto latency = mergedCompletionTime();
+
+        std::cout << "\n=== Статистика кластера ===\n";
+        std::cout << "Время симуляции:        " << std::fixed << std::setprecision(2) << simTime << " сек\n";
+        std::cout << "Узлов × пользователей:  " << m_nodes.size() << " × " << m_users << " (всего)\n";
+        std::cout << "Пропускная способность: " << std::fixed << std::setprecision(3)
+                  << throughput << " задач/сек (" << completions << " завершений)\n";
+        std::cout << "Активных на узле:       среднее " << std::setprecision(3) << activeSum / m_nodes.size()
+                  << ", мин " << minActive << ", макс " << maxActive << "\n";
+        std::cout << "Пользователей:          активных " << std::setprecision(1) << activeSum
+                  << ", в пути " << inFlight << ", простаивают " << m_users - activeSum - inFlight << "\n";
+        std::cout << "Время на узле:          среднее " << std::setprecision(3) << latency.mean()
+                  << ", p50 " << latency.quantile(0.5) << ", p95 " << latency.quantile(0.95)
+                  << ", p99 " << latency.quantile(0.99) << " сек (+ δ = " << m_dispatchDelay << " на доставку)\n";
+        std::cout << "Синхронизация:          " << m_windows << " окон по " << m_syncWindow
+                  << " сек, " << m_messages << " сообщений, " << eventsProcessed() << " событий на узлах\n";
+        std::cout << "Задач по узлам:         ";
+        for (size_t j = 0; j < m_nodes.size(); ++j) {
+            if (j == 8 && m_nodes.size() > 10) {
+                std::cout << " … (ещё " << m_nodes.size() - 8 << ")";
+                break;
+            }
+            std::cout << (j ? ", " : "") << m_nodes[j].routed;
+        }
+        std::cout << "\n(P(k) ниже — на одном узле, среднее по узлам)\n";
+        std::cout << "============================\n";
+        SimulationStats::printDistribution(meanNodeDistribution());
+        std::cout.unsetf(std::ios::floatfield);
+    }
+};
@@ -0,0 +1,112 @@
+// === Comparison.h ===
+#pragma once
+#include "Statistics.h"
+
+#include <vector>
+#include <string>
+#include <iostream>
+#include <iomanip>
+
+// Показатели одного прогона для парного сравнения сценариев
+struct RunMetrics {
+    double utilization = 0.0;   // ρ
+    double meanResponse = 0.0;  // среднее время отклика, сек
+    double throughput = 0.0;    // завершений в секунду
+    // Управляющие переменные: относительное отклонение среднего выданных
+    // простоев и объёмов работы от Distribution::mean(). Их среднее — ноль
+    // с точностью до смещения порядка 1/(число выборок)
+    double passiveDeviation = 0.0;
+    double workloadDeviation = 0.0;
+};
+
+// Парное сравнение сценариев A и B по R прогонам: прогон r обоих сценариев
+// использует один поток ГСЧ, поэтому разность B − A свободна от общей для
+// них случайности. Единица наблюдения — прогон или, с антитетическими
+// парами, среднее пары прогонов (2i, 2i+1). Выигрыш — квадрат отношения
+// полуширины ДИ по независимым прогонам A и B того же числа к полуширине
+// парного ДИ, т. е. во сколько раз меньше нужно прогонов для той же
+// точности. Через полуширины, а не дисперсии, в нём учтены и квантили
+// Стьюдента: у управляющих переменных степеней свободы меньше, и при малом
+// числе единиц это съедает часть выигрыша. Прогоны добавляются по
+// номерам — итог не зависит от числа потоков.
+class PairedComparison {
+    std::vector<RunMetrics> m_a;
+    std::vector<RunMetrics> m_b;
+    bool m_antithetic;
+    bool m_controlVariates;
+
+public:
+    struct Row {
+        double meanA = 0.0;
+        double meanB = 0.0;
+        Stats::MeanCI difference;           // B − A
+        double independentHalfWidth = 0.0;  // ДИ разности по независимым прогонам
+        double gain = 0.0;
+    };
+
+    PairedComparison(bool antithetic, bool controlVariates)
+        : m_antithetic(antithetic), m_controlVariates(controlVariates) {}
+
+    void add(const RunMetrics& a, const RunMetrics& b) {
+        m_a.push_back(a);
+        m_b.push_back(b);
+    }
+
+    size_t runs() const { return m_a.size(); }
+
+    Row compare(double RunMetrics::*metric) const {
+        const size_t runs = m_a.size();
+        const size_t group = m_antithetic ? 2 : 1;
+        const size_t units = runs / group;
+
+        std::vector<double> difference(units, 0.0);
+        std::vector<std::vector<double>> controls(2, std::vector<double>(units, 0.0));
+        for (size_t r = 0; r < units * group; ++r) {
+            size_t u = r / group;
+            difference[u] += (m_b[r].*metric - m_a[r].*metric) / group;
+            controls[0][u] += 0.5 * (m_a[r].passiveDeviation + m_b[r].passiveDeviation) / group;
+            controls[1][u] += 0.5 * (m_a[r].workloadDeviation + m_b[r].workloadDeviation) / group;
+        }
+
+        std::vector<double> a, b;
+        for (size_t r = 0; r < runs; ++r) {
+            a.push_back(m_a[r].*metric);
+            b.push_back(m_b[r].*metric);
+        }
+        auto ciA = Stats::meanCI(a);
+        auto ciB = Stats::meanCI(b);
+
+        Row row;
+        row.meanA = ciA.mean;
+        row.meanB = ciB.mean;
+        row.difference = m_controlVariates ? Stats::controlVariateCI(difference, controls)
+                                           : Stats::meanCI(difference);
+        double independentVariance = (ciA.variance + ciB.variance) / static_cast<double>(runs);
+        row.independentHalfWidth = Stats::studentT975(static_cast<int>(2 * runs) - 2) * std::sqrt(independentVariance);
+        double ratio = row.independentHalfWidth / row.difference.halfWidth;
+        row.gain = row.difference.halfWidth > 0.0 ? ratio * ratio : INFINITY;
+        return row;
+    }
+
+    void printSummary(const std::string& scenario, bool commonRandom) const {
+        std::cout << "\n=== Парное сравнение B − A (95% ДИ) ===\n";
+        std::cout << "Сценарий B:             " << scenario << "\n";
+        std::cout << "Прогонов на сценарий:   " << runs()
+                  << (commonRandom ? ", общие случайные числа" : ", общий поток ГСЧ")
+                  << (m_antithetic ? ", антитетические пары" : "")
+                  << (m_controlVariates ? ", управляющие переменные (простой, объём работы)" : "") << "\n";
+        auto line = [&](const char* label, double RunMetrics::*metric, int precision) {
+            Row row = compare(metric);
+            std::cout << label << std::fixed << std::setprecision(precision)
+                      << "A " << row.meanA << ", B " << row.meanB
+                      << ", B − A = " << row.difference.mean << " ± " << row.difference.halfWidth
+                      << " (независимые прогоны ± " << row.independentHalfWidth
+                      << ", выигрыш ×" << std::setprecision(1) << row.gain << ")\n";
+        };
+        line("Загрузка узла (ρ):      ", &RunMetrics::utilization, 4);
+        line("Время отклика, сек:     ", &RunMetrics::meanResponse, 4);
+        line("Пропускная способность: ", &RunMetrics::throughput, 4);
+        std::cout << "============================\n";
+        std::cout.unsetf(std::ios::floatfield);
+    }
+};
@@ -32,6 +32,25 @@ public:
                 << snapshot.degradationFactor << "\n";
     }
 
+    // Окна агрегации: отдельный набор колонок (снимки в этом режиме не приходят)
+    void onWindow(const WindowSummary& window) override {
+        if (!m_headerWritten) {
+            *m_file << "window_start,window_end,active_mean,active_min,active_max,"
+                    << "rate_mean,rate_min,rate_max\n";
+            m_headerWritten = true;
+        }
+
+        *m_file << std::fixed << std::setprecision(4)
+                << window.start << ","
+                << window.end << ","
+                << window.meanActiveUsers << ","
+                << window.minActiveUsers << ","
+                << window.maxActiveUsers << ","
+                << window.meanEffectiveRate << ","
+                << window.minEffectiveRate << ","
+                << window.maxEffectiveRate << "\n";
+    }
+
     void onSimulationEnd() override {
         if (m_file && m_file->is_open()) {
             m_file->flush();
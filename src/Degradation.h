@@ -0,0 +1,111 @@
+// === Degradation.h ===
+#pragma once
+#include <string>
+#include <vector>
+#include <variant>
+#include <functional>
+#include <stdexcept>
+#include <algorithm>
+#include <cmath>
+
+#include "CliUtils.h"
+
+// Ядра функций деградации f(R): конкретные типы, чтобы специализации
+// BasicSimulator могли встраивать вызов вместо std::function. name() —
+// для контрольных точек: продолжение с другой функцией отвергается
+
+// Гиперболическая: f(R) = 1 / (1 + R/R0)
+struct HyperbolicDegradation {
+    double R0;
+    double operator()(double R) const { return 1.0 / (1.0 + R / R0); }
+    std::string name() const { return "Hyp(R0=" + std::to_string(R0) + ")"; }
+};
+
+// Экспоненциальная: f(R) = exp(-alpha * R)
+struct ExponentialDegradation {
+    double alpha;
+    double operator()(double R) const { return std::exp(-alpha * R); }
+    std::string name() const { return "Exp(α=" + std::to_string(alpha) + ")"; }
+};
+
+// Линейная с обрезкой: f(R) = max(minFactor, 1 - R/Rmax)
+struct LinearDegradation {
+    double Rmax;
+    double minFactor = 0.1;  // минимальный множитель скорости
+    double operator()(double R) const { return std::max(minFactor, 1.0 - R / Rmax); }
+    std::string name() const { return "Lin(Rmax=" + std::to_string(Rmax) + ",min=" + std::to_string(minFactor) + ")"; }
+};
+
+// Пороговая: f(R) = 1 if R<=Rt else min + (1-min)*Rt/R
+struct ThresholdDegradation {
+    double Rt;
+    double minFactor;
+    double operator()(double R) const {
+        return (R <= Rt) ? 1.0 : minFactor + (1.0 - minFactor) * Rt / R;
+    }
+    std::string name() const { return "Thr(Rt=" + std::to_string(Rt) + ",min=" + std::to_string(minFactor) + ")"; }
+};
+
+using DegradationKernel = std::variant<
+    HyperbolicDegradation, ExponentialDegradation, LinearDegradation, ThresholdDegradation>;
+
+// === Фабрика функций деградации ===
+inline DegradationKernel parseDegradation(const std::string& spec) {
+    auto parts = Cli::split(spec, ':');
+    if (parts.empty()) {
+        throw std::invalid_argument("Empty degradation spec");
+    }
+
+    const std::string& type = parts[0];
+    // Параметры: "thr:Rt,min" и "thr:Rt:min" равнозначны
+    std::vector<std::string> params;
+    for (size_t i = 1; i < parts.size(); ++i) {
+        for (auto& p : Cli::split(parts[i], ',')) params.push_back(p);
+    }
+
+    if (type == "hyp" || type == "hyperbolic") {
+        if (params.size() < 1)
+            throw std::invalid_argument("hyperbolic requires 1 param: R0");
+        double R0 = std::stod(params[0]);
+        if (R0 <= 0) throw std::invalid_argument("R0 must be positive");
+        return HyperbolicDegradation{R0};
+    }
+
+    if (type == "exp" || type == "exponential") {
+        if (params.size() < 1)
+            throw std::invalid_argument("exponential requires 1 param: alpha");
+        double alpha = std::stod(params[0]);
+        if (alpha < 0) throw std::invalid_argument("alpha must be non-negative");
+        return ExponentialDegradation{alpha};
+    }
+
+    if (type == "lin" || type == "linear") {
+        if (params.size() < 1)
+            throw std::invalid_argument("linear requires 1 param: Rmax");
+        double Rmax = std::stod(params[0]);
+        if (Rmax <= 0) throw std::invalid_argument("Rmax must be positive");
+        return LinearDegradation{Rmax};
+    }
+
+    if (type == "thr" || type == "threshold") {
+        if (params.size() < 2)
+            throw std::invalid_argument("threshold requires 2 params: Rt, minFactor");
+        double Rt = std::stod(params[0]);
+        double minFactor = std::stod(params[1]);
+        if (Rt <= 0 || minFactor < 0 || minFactor > 1)
+            throw std::invalid_argument("Invalid threshold params");
+        return ThresholdDegradation{Rt, minFactor};
+    }
+
+    throw std::invalid_argument("Unknown degradation type: " + type);
+}
+
+inline std::string degradationName(const DegradationKernel& kernel) {
+    return std::visit([](const auto& k) { return k.name(); }, kernel);
+}
+
+// Та же функция деградации в виде std::function (для обобщённого Simulator)
+inline std::function<double(double)> parseDegradationFn(const std::string& spec) {
+    return std::visit([](auto kernel) -> std::function<double(double)> { return kernel; },
+                      parseDegradation(spec));
+}
@@ -1,29 +1,42 @@
 // src/Distribution.cpp
 #include "Distribution.h"
 #include "RandomGenerator.h"
+#include "BinaryIO.h"
 #include <cmath>
 #include <stdexcept>
 #include <memory>
+#include <algorithm>
 #include <iostream>
 
-// Экспоненциальное распределение
-class ExponentialDist : public Distribution {
-    double rate_;
-public:
-    ExponentialDist(double rate) : rate_(rate) {
-        if (rate <= 0) throw std::invalid_argument("Rate > 0 required");
-    }
-    double sample(std::optional<double> rate) override { 
-        double actualRate = rate.value_or(rate_);
-        return randExponential(actualRate); 
-    }
-    double mean() const override { return 1.0 / rate_; }
-    std::string name() const override { return "Exp(λ=" + std::to_string(rate_) + ")"; }
-    std::unique_ptr<Distribution> clone() const override {
-        return std::make_unique<ExponentialDist>(rate_);
-    }
-};
+void Distribution::sampleBatch(RandomGenerator& rng, double* out, size_t n, std::optional<double> rate) {
+    for (size_t i = 0; i < n; ++i) out[i] = sample(rng, rate);
+}
 
+void Distribution::refill(RandomGenerator& rng) {
+    m_buffer.resize(m_refillSize);
+    m_refillSize = std::min(2 * m_refillSize, kBufferSize);
+    sampleBatch(rng, m_buffer.data(), m_buffer.size());
+    m_bufferPos = 0;
+    m_bufferOwner = &rng;
+}
+
+void Distribution::saveBuffer(std::ostream& out) const {
+    std::vector<double> pending(m_buffer.begin() + m_bufferPos, m_buffer.end());
+    BinaryIO::writeVector(out, pending);
+}
+
+void Distribution::resetBuffer(size_t firstRefill) {
+    m_buffer.clear();
+    m_bufferPos = 0;
+    m_bufferOwner = nullptr;
+    m_refillSize = std::clamp<size_t>(firstRefill, 1, kBufferSize);
+}
+
+void Distribution::loadBuffer(std::istream& in, const RandomGenerator& rng) {
+    m_buffer = BinaryIO::readVector<double>(in);
+    m_bufferPos = 0;
+    m_bufferOwner = &rng;
+}
 
 // Реализация фабрики
 std::unique_ptr<Distribution> DistributionFactory::exponential(double rate) {
@@ -35,10 +48,14 @@ class DeterministicDist : public Distribution {
     double value_;
 public:
     DeterministicDist(double value) : value_(value) {}
-    double sample(std::optional<double> rate) override { 
+    double sample(RandomGenerator& /*rng*/, std::optional<double> /*rate*/) override { 
         return value_; 
     }
+    void sampleBatch(RandomGenerator& /*rng*/, double* out, size_t n, std::optional<double> /*rate*/) override {
+        std::fill(out, out + n, value_);
+    }
     double mean() const override { return value_; }
+    double variance() const override { return 0.0; }
     std::string name() const override { return "Det(" + std::to_string(value_) + ")"; }
     std::unique_ptr<Distribution> clone() const override {
         return std::make_unique<DeterministicDist>(value_);
@@ -56,17 +73,23 @@ public:
     NormalDist(double mean, double stddev) : mean_(mean), stddev_(stddev) {
         if (stddev <= 0) throw std::invalid_argument("Stddev > 0 required");
     }
-    double sample(std::optional<double> rate) override { 
+    double sample(RandomGenerator& rng, std::optional<double> rate) override { 
         if (rate.has_value() && rate.value() > 0) {
             // Масштабируем stddev обратно пропорционально скорости:
             // чем выше rate, тем "уже" распределение
             double scaledStddev = stddev_ / rate.value();
             // mean_ при этом можно оставить как есть или тоже масштабировать
-            return randNormal(mean_, scaledStddev);
+            return rng.normal(mean_, scaledStddev);
         }
-        return randNormal(mean_, stddev_); 
+        return rng.normal(mean_, stddev_); 
+    }
+    void sampleBatch(RandomGenerator& rng, double* out, size_t n, std::optional<double> rate) override {
+        const double stddev = (rate.has_value() && rate.value() > 0) ? stddev_ / rate.value() : stddev_;
+        rng.fillStandardNormal(out, n);
+        for (size_t i = 0; i < n; ++i) out[i] = mean_ + stddev * out[i];
     }
     double mean() const override { return mean_; }
+    double variance() const override { return stddev_ * stddev_; }
     std::string name() const override { 
         return "N(μ=" + std::to_string(mean_) + ",σ²=" + std::to_string(stddev_*stddev_) + ")"; 
     }
@@ -86,15 +109,22 @@ public:
     GammaDist(double shape, double scale) : shape_(shape), scale_(scale) {
         if (shape <= 0 || scale <= 0) throw std::invalid_argument("Shape and scale > 0 required");
     }
-    double sample(std::optional<double> rate) override { 
+    double sample(RandomGenerator& rng, std::optional<double> rate) override { 
         if (rate.has_value()) {
             // Сохраняем форму (shape), но масштабируем время через scale
             // Новый scale = 1 / rate, тогда mean = shape * (1/rate)
-            return randGamma(shape_, 1.0 / rate.value());
+            return rng.gamma(shape_, 1.0 / rate.value());
         }
-        return randGamma(shape_, scale_); 
+        return rng.gamma(shape_, scale_); 
+    }
+    void sampleBatch(RandomGenerator& rng, double* out, size_t n, std::optional<double> rate) override {
+        const double scale = rate.has_value() ? 1.0 / rate.value() : scale_;
+        rng.fillStandardGamma(shape_, out, n);
+        for (size_t i = 0; i < n; ++i) out[i] *= scale;
     }
     double mean() const override { return shape_ * scale_; }
+    double variance() const override { return shape_ * scale_ * scale_; }
+    std::optional<double> rateScaledMean() const override { return shape_; }
     std::string name() const override { 
         return "Γ(shape=" + std::to_string(shape_) + ",scale=" + std::to_string(scale_) + ")"; 
     }
@@ -114,17 +144,27 @@ public:
     LognormalDist(double mu, double sigma) : mu_(mu), sigma_(sigma) {
         if (sigma <= 0) throw std::invalid_argument("Sigma > 0 required");
     }
-    double sample(std::optional<double> rate) override { 
+    double sample(RandomGenerator& rng, std::optional<double> rate) override { 
         if (rate.has_value()) {
             // Фиксируем "форму" (sigma), подбираем mu под нужное среднее
             double newMu = std::log(1.0 / rate.value()) - 0.5 * sigma_ * sigma_;
-            return randLognormal(newMu, sigma_);
+            return rng.lognormal(newMu, sigma_);
         }
-        return randLognormal(mu_, sigma_); 
+        return rng.lognormal(mu_, sigma_); 
+    }
+    void sampleBatch(RandomGenerator& rng, double* out, size_t n, std::optional<double> rate) override {
+        const double mu = rate.has_value() ? std::log(1.0 / rate.value()) - 0.5 * sigma_ * sigma_ : mu_;
+        rng.fillStandardNormal(out, n);
+        for (size_t i = 0; i < n; ++i) out[i] = std::exp(mu + sigma_ * out[i]);
     }
     double mean() const override { 
         return std::exp(mu_ + 0.5 * sigma_ * sigma_);  // E[X] = exp(μ + σ²/2)
     }
+    double variance() const override {
+        double s2 = sigma_ * sigma_;
+        return (std::exp(s2) - 1.0) * std::exp(2.0 * mu_ + s2);
+    }
+    std::optional<double> rateScaledMean() const override { return 1.0; }
     std::string name() const override { 
         return "LogN(μ=" + std::to_string(mu_) + ",σ²=" + std::to_string(sigma_*sigma_) + ")"; 
     }
@@ -146,14 +186,24 @@ public:
         if (min_ >= max_) throw std::invalid_argument("Uniform: min < max required");
     }
     
-    double sample(std::optional<double> rate) override { 
-        return randUniform(min_, max_); 
+    double sample(RandomGenerator& rng, std::optional<double> /*rate*/) override { 
+        return rng.uniform(min_, max_); 
+    }
+    
+    void sampleBatch(RandomGenerator& rng, double* out, size_t n, std::optional<double> /*rate*/) override {
+        const double width = max_ - min_;
+        rng.fillUniform01(out, n);
+        for (size_t i = 0; i < n; ++i) out[i] = min_ + width * out[i];
     }
     
     double mean() const override { 
         return (min_ + max_) / 2.0;  // E[X] = (a+b)/2
     }
     
+    double variance() const override {
+        return (max_ - min_) * (max_ - min_) / 12.0;
+    }
+    
     std::string name() const override { 
         return "U(min=" + std::to_string(min_) + ",max=" + std::to_string(max_) + ")"; 
     }
@@ -165,4 +215,178 @@ public:
 
 std::unique_ptr<Distribution> DistributionFactory::uniform(double min, double max) {
     return std::make_unique<UniformDist>(min, max);
-}
\ No newline at end of file
+}
+// === Фазовое распределение ===
+namespace {
+
+// Решение (I − P)x = b для небольшого числа фаз (Гаусс с выбором ведущего)
+std::vector<double> solveAbsorbing(const std::vector<std::vector<double>>& P, std::vector<double> b) {
+    const size_t n = b.size();
+    std::vector<std::vector<double>> a(n, std::vector<double>(n));
+    for (size_t i = 0; i < n; ++i)
+        for (size_t j = 0; j < n; ++j) a[i][j] = (i == j ? 1.0 : 0.0) - P[i][j];
+    
+    for (size_t col = 0; col < n; ++col) {
+        size_t pivot = col;
+        for (size_t r = col + 1; r < n; ++r)
+            if (std::abs(a[r][col]) > std::abs(a[pivot][col])) pivot = r;
+        if (std::abs(a[pivot][col]) < 1e-14)
+            throw std::invalid_argument("Phase-type: absorption is not reachable from every phase");
+        std::swap(a[col], a[pivot]);
+        std::swap(b[col], b[pivot]);
+        for (size_t r = col + 1; r < n; ++r) {
+            double factor = a[r][col] / a[col][col];
+            for (size_t c = col; c < n; ++c) a[r][c] -= factor * a[col][c];
+            b[r] -= factor * b[col];
+        }
+    }
+    std::vector<double> x(n);
+    for (size_t i = n; i-- > 0;) {
+        double sum = b[i];
+        for (size_t j = i + 1; j < n; ++j) sum -= a[i][j] * x[j];
+        x[i] = sum / a[i][i];
+    }
+    return x;
+}
+
+std::vector<double> cumulative(const std::vector<double>& p) {
+    std::vector<double> c(p.size());
+    double sum = 0.0;
+    for (size_t i = 0; i < p.size(); ++i) c[i] = (sum += p[i]);
+    return c;
+}
+
+} // namespace
+
+PhaseTypeDist::PhaseTypeDist(std::vector<double> alpha, std::vector<double> rates,
+                             std::vector<std::vector<double>> transition)
+    : alpha_(std::move(alpha)), rates_(std::move(rates)), transition_(std::move(transition)) {
+    const size_t n = rates_.size();
+    if (n == 0 || alpha_.size() != n || transition_.size() != n)
+        throw std::invalid_argument("Phase-type: alpha, rates and transitions must have the same size");
+    double alphaSum = 0.0;
+    for (size_t i = 0; i < n; ++i) {
+        if (rates_[i] <= 0.0) throw std::invalid_argument("Phase-type: phase rates must be positive");
+        if (alpha_[i] < 0.0 || transition_[i].size() != n)
+            throw std::invalid_argument("Phase-type: invalid initial or transition probabilities");
+        alphaSum += alpha_[i];
+        double rowSum = 0.0;
+        for (double p : transition_[i]) {
+            if (p < 0.0) throw std::invalid_argument("Phase-type: negative transition probability");
+            rowSum += p;
+        }
+        if (rowSum > 1.0 + 1e-12) throw std::invalid_argument("Phase-type: transition row sums above 1");
+    }
+    if (std::abs(alphaSum - 1.0) > 1e-9) throw std::invalid_argument("Phase-type: alpha must sum to 1");
+    
+    alphaCumulative_ = cumulative(alpha_);
+    for (const auto& row : transition_) transitionCumulative_.push_back(cumulative(row));
+    
+    // Моменты времени до поглощения из каждой фазы:
+    // τ = (I−P)⁻¹·(1/r),  s = (I−P)⁻¹·(2/r² + 2/r·Pτ)
+    std::vector<double> holding(n);
+    for (size_t i = 0; i < n; ++i) holding[i] = 1.0 / rates_[i];
+    auto tau = solveAbsorbing(transition_, holding);
+    std::vector<double> rhs(n);
+    for (size_t i = 0; i < n; ++i) {
+        double next = 0.0;
+        for (size_t j = 0; j < n; ++j) next += transition_[i][j] * tau[j];
+        rhs[i] = 2.0 * holding[i] * holding[i] + 2.0 * holding[i] * next;
+    }
+    auto second = solveAbsorbing(transition_, rhs);
+    for (size_t i = 0; i < n; ++i) {
+        mean_ += alpha_[i] * tau[i];
+        secondMoment_ += alpha_[i] * second[i];
+    }
+}
+
+PhaseTypeDist PhaseTypeDist::fitMoments(double mean, double scv, int maxPhases) {
+    if (mean <= 0.0 || scv < 0.0) throw std::invalid_argument("Phase-type fit needs mean > 0 and SCV >= 0");
+    if (maxPhases < 1) throw std::invalid_argument("Phase-type fit needs at least one phase");
+    
+    if (std::abs(scv - 1.0) < 1e-9 || maxPhases == 1) {
+        return PhaseTypeDist({1.0}, {1.0 / mean}, {{0.0}});
+    }
+    if (scv > 1.0) {
+        // H2 со сбалансированными средними: p1/μ1 = p2/μ2
+        double p1 = 0.5 * (1.0 + std::sqrt((scv - 1.0) / (scv + 1.0)));
+        double p2 = 1.0 - p1;
+        return PhaseTypeDist({p1, p2}, {2.0 * p1 / mean, 2.0 * p2 / mean}, {{0.0, 0.0}, {0.0, 0.0}});
+    }
+    
+    double p = 0.0;  // доля Erlang(k−1)
+    int k = maxPhases;
+    if (scv * maxPhases >= 1.0) {
+        k = static_cast<int>(std::ceil(1.0 / scv - 1e-9));
+        p = (k * scv - std::sqrt(k * (1.0 + scv) - k * k * scv)) / (1.0 + scv);
+        p = std::clamp(p, 0.0, 1.0);
+    }
+    double rate = (k - p) / mean;
+    
+    // Цепочка из k фаз; старт со второй фазы даёт Erlang(k−1)
+    std::vector<double> alpha(k, 0.0);
+    alpha[0] = 1.0 - p;
+    alpha[1] += p;
+    std::vector<std::vector<double>> transition(k, std::vector<double>(k, 0.0));
+    for (int i = 0; i + 1 < k; ++i) transition[i][i + 1] = 1.0;
+    return PhaseTypeDist(alpha, std::vector<double>(k, rate), transition);
+}
+
+PhaseTypeDist PhaseTypeDist::fit(const Distribution& dist, int maxPhases) {
+    if (auto* ph = dynamic_cast<const PhaseTypeDist*>(&dist)) return *ph;
+    double mean = dist.mean();
+    if (mean <= 0.0) throw std::invalid_argument("Phase-type fit needs a positive mean: " + dist.name());
+    return fitMoments(mean, dist.variance() / (mean * mean), maxPhases);
+}
+
+PhaseTypeDist PhaseTypeDist::fitSamples(const std::vector<double>& samples, int maxPhases) {
+    if (samples.size() < 2) throw std::invalid_argument("Phase-type fit needs at least two samples");
+    double mean = 0.0;
+    for (double x : samples) mean += x;
+    mean /= samples.size();
+    double var = 0.0;
+    for (double x : samples) var += (x - mean) * (x - mean);
+    var /= (samples.size() - 1);
+    return fitMoments(mean, var / (mean * mean), maxPhases);
+}
+
+PhaseTypeDist PhaseTypeDist::scaledToMean(double mean) const {
+    if (mean <= 0.0) throw std::invalid_argument("Phase-type: target mean must be positive");
+    std::vector<double> rates = rates_;
+    for (double& r : rates) r *= mean_ / mean;
+    return PhaseTypeDist(alpha_, rates, transition_);
+}
+
+double PhaseTypeDist::exitProbability(size_t i) const {
+    double stay = 0.0;
+    for (double p : transition_[i]) stay += p;
+    return std::max(0.0, 1.0 - stay);
+}
+
+size_t PhaseTypeDist::pickPhase(const std::vector<double>& cumulative, double u) const {
+    return static_cast<size_t>(std::upper_bound(cumulative.begin(), cumulative.end(), u) - cumulative.begin());
+}
+
+double PhaseTypeDist::sampleUnscaled(RandomGenerator& rng) const {
+    size_t phase = std::min(pickPhase(alphaCumulative_, rng.uniform01()), phases() - 1);
+    double time = 0.0;
+    while (true) {
+        time += rng.standardExponential() / rates_[phase];
+        phase = pickPhase(transitionCumulative_[phase], rng.uniform01());
+        if (phase >= phases()) return time;  // за пределами суммы строки — поглощение
+    }
+}
+
+double PhaseTypeDist::sample(RandomGenerator& rng, std::optional<double> rate) {
+    double time = sampleUnscaled(rng);
+    return rate.has_value() ? time / (mean_ * rate.value()) : time;
+}
+
+std::string PhaseTypeDist::name() const {
+    return "PH(phases=" + std::to_string(phases()) + ",mean=" + std::to_string(mean_)
+         + ",scv=" + std::to_string(variance() / (mean_ * mean_)) + ")";
+}
+
+std::unique_ptr<Distribution> DistributionFactory::phaseType(double mean, double scv) {
+    return std::make_unique<PhaseTypeDist>(PhaseTypeDist::fitMoments(mean, scv));
+}
@@ -6,22 +6,145 @@
 #include <string>
 #include <functional>
 #include <optional>
+#include <vector>
+#include <cstddef>
+#include <stdexcept>
+#include <istream>
+#include <ostream>
+
+#include "RandomGenerator.h"
 
 class Distribution {
 public:
     virtual ~Distribution() = default;
     
-    // Генерация случайной величины
-    virtual double sample(std::optional<double> rate = std::nullopt) = 0;
+    // Генерация случайной величины из генератора rng
+    virtual double sample(RandomGenerator& rng, std::optional<double> rate = std::nullopt) = 0;
+    
+    // Пакетная генерация n величин: параметры разрешаются один раз на пакет.
+    // По умолчанию — n вызовов sample
+    virtual void sampleBatch(RandomGenerator& rng, double* out, size_t n,
+                             std::optional<double> rate = std::nullopt);
+    
+    // Величина из внутреннего буфера, пополняемого через sampleBatch.
+    // Буфер привязан к генератору: при смене rng остаток отбрасывается
+    double next(RandomGenerator& rng) {
+        if (m_bufferPos == m_buffer.size() || m_bufferOwner != &rng) refill(rng);
+        return m_buffer[m_bufferPos++];
+    }
+    
+    // Сохранение/восстановление ещё не выданных величин буфера: без них
+    // продолженный прогон разошёлся бы с непрерывным. После загрузки
+    // буфер привязывается к генератору rng
+    void saveBuffer(std::ostream& out) const;
+    void loadBuffer(std::istream& in, const RandomGenerator& rng);
+    
+    // Отбросить буфер; следующее пополнение — firstRefill величин, далее
+    // вдвое больше до обычного размера. Для короткоживущих копий (повторные
+    // испытания расщепления), которым полный пакет почти весь не нужен
+    void resetBuffer(size_t firstRefill);
     
     // Среднее значение (для аналитических расчётов)
     virtual double mean() const = 0;
     
+    // Дисперсия (для подбора фазового распределения по моментам)
+    virtual double variance() const = 0;
+    
+    // Среднее sample(rng, 1.0), если rate лишь масштабирует время и форма
+    // распределения сохраняется; nullopt — если rate меняет форму или
+    // игнорируется (тогда аналитическое решение неприменимо)
+    virtual std::optional<double> rateScaledMean() const { return std::nullopt; }
+    
     // Имя распределения (для логгирования/отладки)
     virtual std::string name() const = 0;
     
     // Клонирование (для безопасного копирования)
     virtual std::unique_ptr<Distribution> clone() const = 0;
+
+private:
+    static constexpr size_t kBufferSize = 256;
+    
+    std::vector<double> m_buffer;
+    size_t m_bufferPos = 0;
+    size_t m_refillSize = kBufferSize;
+    const RandomGenerator* m_bufferOwner = nullptr;
+    
+    void refill(RandomGenerator& rng);
+};
+
+// Экспоненциальное распределение. Объявлено в заголовке и final, чтобы
+// специализации BasicSimulator вызывали его без виртуальной диспетчеризации
+class ExponentialDist final : public Distribution {
+    double rate_;
+public:
+    ExponentialDist(double rate) : rate_(rate) {
+        if (rate <= 0) throw std::invalid_argument("Rate > 0 required");
+    }
+    double sample(RandomGenerator& rng, std::optional<double> rate = std::nullopt) override { 
+        double actualRate = rate.value_or(rate_);
+        return rng.exponential(actualRate); 
+    }
+    void sampleBatch(RandomGenerator& rng, double* out, size_t n,
+                     std::optional<double> rate = std::nullopt) override {
+        const double scale = 1.0 / rate.value_or(rate_);
+        rng.fillStandardExponential(out, n);
+        for (size_t i = 0; i < n; ++i) out[i] *= scale;
+    }
+    double rate() const { return rate_; }
+    double mean() const override { return 1.0 / rate_; }
+    double variance() const override { return 1.0 / (rate_ * rate_); }
+    std::optional<double> rateScaledMean() const override { return 1.0; }
+    std::string name() const override { return "Exp(λ=" + std::to_string(rate_) + ")"; }
+    std::unique_ptr<Distribution> clone() const override {
+        return std::make_unique<ExponentialDist>(rate_);
+    }
+};
+
+// Фазовое (phase-type) распределение: время до поглощения марковской цепи
+// с phases() переходными фазами. Из фазы i цепь уходит с интенсивностью
+// rate(i): в фазу j с вероятностью transition(i, j), иначе поглощается.
+// Объявлено в заголовке, чтобы аналитический решатель видел структуру фаз.
+// При sample(rng, rate) время масштабируется к среднему 1/rate.
+class PhaseTypeDist final : public Distribution {
+    std::vector<double> alpha_;                   // начальное распределение по фазам
+    std::vector<double> rates_;                   // интенсивность выхода из фазы
+    std::vector<std::vector<double>> transition_; // вероятности переходов между фазами
+    std::vector<double> alphaCumulative_;         // для выбора фаз при генерации
+    std::vector<std::vector<double>> transitionCumulative_;
+    double mean_ = 0.0;
+    double secondMoment_ = 0.0;
+    
+    size_t pickPhase(const std::vector<double>& cumulative, double u) const;
+    double sampleUnscaled(RandomGenerator& rng) const;
+    
+public:
+    PhaseTypeDist(std::vector<double> alpha, std::vector<double> rates,
+                  std::vector<std::vector<double>> transition);
+    
+    // Подбор по двум моментам (SCV = Var/E²): SCV = 1 — экспонента; SCV > 1 —
+    // гиперэкспонента H2 со сбалансированными средними; SCV < 1 — смесь
+    // Erlang(k−1) и Erlang(k) с общей интенсивностью, k = ⌈1/SCV⌉ (Tijms).
+    // Если k > maxPhases, берётся Erlang(maxPhases) с точным средним
+    static PhaseTypeDist fitMoments(double mean, double scv, int maxPhases = 8);
+    static PhaseTypeDist fit(const Distribution& dist, int maxPhases = 8);
+    static PhaseTypeDist fitSamples(const std::vector<double>& samples, int maxPhases = 8);
+    // То же распределение, растянутое по времени до заданного среднего
+    PhaseTypeDist scaledToMean(double mean) const;
+    
+    size_t phases() const { return rates_.size(); }
+    double initialProbability(size_t i) const { return alpha_[i]; }
+    double rate(size_t i) const { return rates_[i]; }
+    double transition(size_t i, size_t j) const { return transition_[i][j]; }
+    double exitProbability(size_t i) const;
+    
+    double sample(RandomGenerator& rng, std::optional<double> rate = std::nullopt) override;
+    double mean() const override { return mean_; }
+    double variance() const override { return secondMoment_ - mean_ * mean_; }
+    std::optional<double> rateScaledMean() const override { return 1.0; }
+    std::string name() const override;
+    std::unique_ptr<Distribution> clone() const override {
+        return std::make_unique<PhaseTypeDist>(*this);
+    }
 };
 
 // Фабрика распределений
@@ -45,6 +168,32 @@ public:
     // Равномерное распределение
     static std::unique_ptr<Distribution> uniform(double min, double max);
     
+    // Фазовое распределение, подобранное по среднему и SCV
+    static std::unique_ptr<Distribution> phaseType(double mean, double scv);
+
+};
+
+// Владеющий указатель с глубоким копированием через clone(): делает
+// копируемым объект, владеющий распределениями (копия симулятора при
+// расщеплении траекторий). clone() типа T возвращает объект того же типа
+template <class T>
+class ClonePtr {
+    std::unique_ptr<T> m_ptr;
+
+public:
+    ClonePtr(std::unique_ptr<T> ptr) : m_ptr(std::move(ptr)) {}
+    ClonePtr(const ClonePtr& other)
+        : m_ptr(other.m_ptr ? static_cast<T*>(other.m_ptr->clone().release()) : nullptr) {}
+    ClonePtr(ClonePtr&&) noexcept = default;
+    ClonePtr& operator=(ClonePtr other) noexcept {
+        m_ptr = std::move(other.m_ptr);
+        return *this;
+    }
+
+    T* get() const { return m_ptr.get(); }
+    T* operator->() const { return m_ptr.get(); }
+    T& operator*() const { return *m_ptr; }
+    explicit operator bool() const { return m_ptr != nullptr; }
 };
 
 #endif // DISTRIBUTION_H
\ No newline at end of file
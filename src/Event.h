@@ -3,36 +3,52 @@
 
 #include <string>
 #include <memory>
-#include <functional>
+#include <type_traits>
 #include <cstdint>  // для uint64_t
 
-enum class EventType {
+// Мониторинг не является событием очереди: тики выполняются в
+// Simulator::runUntil при пересечении границ интервала
+enum class EventType : uint8_t {
     ACTIVATION,
-    DEACTIVATION,
-    MONITORING
+    DEACTIVATION
 };
 
+// Событие — тривиально копируемая запись; обработчик выбирается
+// в Simulator::runUntil по type(), без std::function и аллокаций.
+// 24 байта: тип хранится в старших битах ключа порядка, поэтому
+// сравнение по (тип, порядок постановки) — одно сравнение целых
 struct Event {
+    static constexpr int kTypeShift = 56;
+    static constexpr uint64_t kSequenceMask = (uint64_t{1} << kTypeShift) - 1;
+
     double time;
-    EventType type;
-    int userId;
-    uint64_t sequenceId;  // ← НОВОЕ: уникальный ID для уникальности в std::set
-    uint64_t eventVersion; // версия события для lazy deletion
-    std::function<void()> handler;
-    
-    // Конструктор для удобства
-    Event(double t, EventType ty, int uid, uint64_t seq, uint64_t ver, std::function<void()> h)
-        : time(t), type(ty), userId(uid), sequenceId(seq), eventVersion(ver), handler(std::move(h)) {}
-    
-    // Компаратор для std::set: мин-куча по времени + приоритет по типу + уникальность
+    uint64_t order;         // тип << 56 | порядок постановки (стабильный tie-break)
+    int32_t userId;
+    uint32_t eventVersion;  // версия события пользователя
+
+    Event() = default;
+    Event(double t, EventType type, int32_t user, uint64_t sequenceId, uint32_t version)
+        : time(t),
+          order(static_cast<uint64_t>(type) << kTypeShift | (sequenceId & kSequenceMask)),
+          userId(user),
+          eventVersion(version) {}
+
+    EventType type() const { return static_cast<EventType>(order >> kTypeShift); }
+    uint64_t sequenceId() const { return order & kSequenceMask; }
+    void setSequenceId(uint64_t sequenceId) {
+        order = (order & ~kSequenceMask) | (sequenceId & kSequenceMask);
+    }
+
+    // Компаратор кучи: по времени, затем по типу, затем по порядку постановки
     bool operator<(const Event& other) const {
-        if (time != other.time) return time < other.time;                    // 1. по времени
-        if (static_cast<int>(type) != static_cast<int>(other.type))          // 2. по типу
-            return static_cast<int>(type) < static_cast<int>(other.type);
-        return sequenceId < other.sequenceId;                                // 3. по ID (гарантия уникальности)
+        if (time != other.time) return time < other.time;
+        return order < other.order;
     }
 };
 
+static_assert(std::is_trivially_copyable<Event>::value, "Event must stay a POD");
+static_assert(sizeof(Event) == 24, "Event layout is part of the per-user memory budget");
+
 class EventHandler {
 public:
     virtual ~EventHandler() = default;
@@ -1,42 +1,182 @@
 #include "EventQueue.h"
+#include "BinaryIO.h"
 #include <stdexcept>
+#include <algorithm>
 
-void EventQueue::push(double time, EventType type, int userId, uint64_t eventVersion, std::function<void()> handler) {
-    Event event(time, type, userId, nextSequenceId_++, eventVersion, std::move(handler));
-    events_.insert(event);
+void EventQueue::reserve(int userSlots) {
+    size_t slots = static_cast<size_t>(std::max(userSlots, 0)) + 1;
+    heap_.reserve(slots);
+    if (position_.size() < slots) position_.resize(slots, kNoPosition);
+}
+
+void EventQueue::place(size_t index, const Event& event) {
+    heap_[index] = event;
+    position_[slotOf(heap_[index].userId)] = static_cast<uint32_t>(index);
+}
+
+void EventQueue::siftUp(size_t index) {
+    if (index == 0) return;
+    Event moving = heap_[index];
+    while (index > 0) {
+        size_t parent = (index - 1) / kArity;
+        if (!(moving < heap_[parent])) break;
+        place(index, heap_[parent]);
+        index = parent;
+    }
+    place(index, moving);
+}
+
+void EventQueue::siftDown(size_t index) {
+    const size_t n = heap_.size();
+    Event moving = heap_[index];
+    while (true) {
+        size_t first = index * kArity + 1;
+        if (first >= n) break;
+        size_t last = std::min(first + kArity, n);
+        size_t best = first;
+        for (size_t c = first + 1; c < last; ++c) {
+            if (heap_[c] < heap_[best]) best = c;
+        }
+        if (!(heap_[best] < moving)) break;
+        place(index, heap_[best]);
+        index = best;
+    }
+    place(index, moving);
+}
+
+void EventQueue::restore(size_t index) {
+    if (index > 0 && heap_[index] < heap_[(index - 1) / kArity]) {
+        siftUp(index);
+    } else {
+        siftDown(index);
+    }
+}
+
+void EventQueue::removeAt(size_t index) {
+    position_[slotOf(heap_[index].userId)] = kNoPosition;
+    size_t lastIndex = heap_.size() - 1;
+    if (index != lastIndex) {
+        place(index, heap_[lastIndex]);
+        heap_.pop_back();
+        restore(index);
+    } else {
+        heap_.pop_back();
+    }
+}
+
+void EventQueue::push(double time, EventType type, int userId, uint32_t eventVersion) {
+    size_t slot = slotOf(userId);
+    if (slot >= position_.size()) position_.resize(slot + 1, kNoPosition);
+
+    Event event(time, type, userId, nextSequenceId_++, eventVersion);
+    size_t index = position_[slot];
+    if (index != kNoPosition) {
+        place(index, event);
+        restore(index);
+        return;
+    }
+    heap_.push_back(event);
+    position_[slot] = static_cast<uint32_t>(heap_.size() - 1);
+    siftUp(heap_.size() - 1);
+}
+
+void EventQueue::reschedule(int userId, double newTime) {
+    reschedule(userId, newTime, nextSequenceId_++);
+}
+
+void EventQueue::reschedule(int userId, double newTime, uint64_t sequenceId) {
+    if (!contains(userId)) throw std::runtime_error("Reschedule of a missing event");
+    size_t index = position_[slotOf(userId)];
+    heap_[index].time = newTime;
+    heap_[index].setSequenceId(sequenceId);
+    restore(index);
+}
+
+uint64_t EventQueue::reserveSequence(uint64_t count) {
+    uint64_t first = nextSequenceId_;
+    nextSequenceId_ += count;
+    return first;
+}
+
+bool EventQueue::cancel(int userId) {
+    if (!contains(userId)) return false;
+    removeAt(position_[slotOf(userId)]);
+    return true;
+}
+
+bool EventQueue::contains(int userId) const {
+    size_t slot = slotOf(userId);
+    return slot < position_.size() && position_[slot] != kNoPosition;
+}
+
+double EventQueue::scheduledTime(int userId) const {
+    if (!contains(userId)) throw std::runtime_error("No event scheduled for user");
+    return heap_[position_[slotOf(userId)]].time;
 }
 
 Event EventQueue::pop() {
     if (empty()) throw std::runtime_error("Pop from empty event queue");
-    auto it = events_.begin();
-    Event event = *it;
-    events_.erase(it);
+    Event event = heap_.front();
+    position_[slotOf(event.userId)] = kNoPosition;
+    if (heap_.size() > 1) {
+        place(0, heap_.back());
+        heap_.pop_back();
+        siftDown(0);
+    } else {
+        heap_.pop_back();
+    }
     return event;
 }
 
 const Event& EventQueue::peek() const {
     if (empty()) throw std::runtime_error("Peek from empty event queue");
-    return *events_.begin();
+    return heap_.front();
 }
 
 bool EventQueue::empty() const {
-    return events_.empty();
+    return heap_.empty();
 }
 
 size_t EventQueue::size() const {
-    return events_.size();
+    return heap_.size();
+}
+
+size_t EventQueue::memoryBytes() const {
+    return heap_.capacity() * sizeof(Event) + position_.capacity() * sizeof(uint32_t);
+}
+
+void EventQueue::save(std::ostream& out) const {
+    BinaryIO::write<uint64_t>(out, nextSequenceId_);
+    BinaryIO::writeVector(out, heap_);
+}
+
+void EventQueue::load(std::istream& in) {
+    nextSequenceId_ = BinaryIO::read<uint64_t>(in);
+    heap_ = BinaryIO::readVector<Event>(in);
+    std::fill(position_.begin(), position_.end(), kNoPosition);
+    for (size_t i = 0; i < heap_.size(); ++i) {
+        size_t slot = slotOf(heap_[i].userId);
+        if (slot >= position_.size()) position_.resize(slot + 1, kNoPosition);
+        position_[slot] = static_cast<uint32_t>(i);
+    }
 }
 
 void EventQueue::debugPrint(size_t n) const {
+    std::vector<const Event*> ordered;
+    ordered.reserve(heap_.size());
+    for (const auto& e : heap_) ordered.push_back(&e);
+    n = std::min(n, ordered.size());
+    std::partial_sort(ordered.begin(), ordered.begin() + n, ordered.end(),
+                      [](const Event* a, const Event* b) { return *a < *b; });
+
     std::cout << "=== Event Queue (next " << n << ") ===\n";
-    size_t i = 0;
-    for (const auto& e : events_) {
-        if (i++ >= n) break;
-        std::cout << "[" << i-1 << "] t=" << e.time 
-                  << " type=" << static_cast<int>(e.type) 
-                  << " userId=" << e.userId 
+    for (size_t i = 0; i < n; ++i) {
+        const Event& e = *ordered[i];
+        std::cout << "[" << i << "] t=" << e.time
+                  << " type=" << static_cast<int>(e.type())
+                  << " userId=" << e.userId
                   << " ver=" << e.eventVersion
-                  << " seq=" << e.sequenceId << "\n";
+                  << " seq=" << e.sequenceId() << "\n";
     }
     std::cout << "===========================\n";
-}
\ No newline at end of file
+}
@@ -2,27 +2,70 @@
 #define EVENT_QUEUE_H
 
 #include "Event.h"
-#include <set>
 #include <vector>
-#include <functional>
 #include <cstdint>
+#include <cstddef>
 #include <iostream>
 
+// Индексированная 4-арная min-куча событий.
+// У каждого пользователя не более одного живого события: повторный push
+// для того же userId переносит существующее событие (O(log n)), а не
+// добавляет новое. Все системные события (userId < 0) делят один слот.
 class EventQueue {
 private:
-    std::set<Event> events_;
-    uint64_t nextSequenceId_ = 0;  // для уникальности sequenceId
-    
+    static constexpr size_t kArity = 4;
+    static constexpr uint32_t kNoPosition = static_cast<uint32_t>(-1);
+
+    std::vector<Event> heap_;
+    std::vector<uint32_t> position_; // слот -> индекс в heap_ (kNoPosition, если события нет)
+    uint64_t nextSequenceId_ = 0;   // для стабильного порядка при равных time/type
+
+    static size_t slotOf(int userId) { return userId < 0 ? 0 : static_cast<size_t>(userId) + 1; }
+
+    void place(size_t index, const Event& event);
+    void siftUp(size_t index);
+    void siftDown(size_t index);
+    void restore(size_t index);
+    void removeAt(size_t index);
+
 public:
-    // 🔥 ОБНОВЛЕНО: добавлен параметр eventVersion
-    void push(double time, EventType type, int userId, uint64_t eventVersion, std::function<void()> handler);
-    
+    EventQueue() = default;
+    explicit EventQueue(int userSlots) { reserve(userSlots); }
+
+    // Резервирует место под userSlots пользователей (+ системный слот)
+    void reserve(int userSlots);
+
+    // Планирует событие; если у userId уже есть событие, оно заменяется
+    void push(double time, EventType type, int userId, uint32_t eventVersion);
+
+    // Переносит уже запланированное событие пользователя на newTime
+    void reschedule(int userId, double newTime);
+    // То же с заранее зарезервированным номером постановки (см. reserveSequence)
+    void reschedule(int userId, double newTime, uint64_t sequenceId);
+
+    // Резервирует count номеров постановки и возвращает первый: отложенный
+    // перенос событий получает тот же порядок, что и немедленный
+    uint64_t reserveSequence(uint64_t count);
+
+    // Удаляет событие пользователя; false, если его не было
+    bool cancel(int userId);
+
+    bool contains(int userId) const;
+    double scheduledTime(int userId) const;
+
     Event pop();
     const Event& peek() const;
     bool empty() const;
     size_t size() const;
-    
+
+    // Память под кучу и индекс слотов (по ёмкости векторов)
+    size_t memoryBytes() const;
+
+    // Сохранение/восстановление содержимого очереди (для контрольных точек)
+    void save(std::ostream& out) const;
+    void load(std::istream& in);
+
     void debugPrint(size_t n = 5) const;
 };
 
-#endif // EVENT_QUEUE_H
\ No newline at end of file
+#endif // EVENT_QUEUE_H
@@ -0,0 +1,25 @@
+#pragma once
+#include <vector>
+#include <functional>
+#include <cstddef>
+
+class RandomGenerator;
+
+// Загрузка узла кластера, видимая диспетчеру в момент активации:
+// задачи на узле плюс уже отправленные, но ещё не дошедшие до него
+struct NodeLoad {
+    int tasks = 0;
+    double workload = 0.0;  // суммарный объём работы этих задач
+};
+
+// Эффективная скорость узла node при суммарном объёме работы R
+using NodeRateFn = std::function<double(size_t node, double totalWorkload)>;
+
+// Политика маршрутизации: выбирает узел для новой задачи с объёмом работы
+// workload. Вызывается только из диспетчера, поэтому может хранить состояние
+class IRoutingPolicy {
+public:
+    virtual ~IRoutingPolicy() = default;
+    virtual size_t route(const std::vector<NodeLoad>& nodes, double workload,
+                         const NodeRateFn& rate, RandomGenerator& rng) = 0;
+};
@@ -10,9 +10,23 @@ struct SimulationSnapshot {
     // Можно добавить другие метрики по требованию
 };
 
+// Сводка за окно агрегации [start, end): средние взвешены по времени
+struct WindowSummary {
+    double start;
+    double end;
+    double meanActiveUsers;
+    int minActiveUsers;
+    int maxActiveUsers;
+    double meanEffectiveRate;
+    double minEffectiveRate;
+    double maxEffectiveRate;
+};
+
 class ISimulationListener {
 public:
     virtual ~ISimulationListener() = default;
     virtual void onSnapshot(const SimulationSnapshot& snapshot) = 0;
+    // Вызывается вместо onSnapshot, если в симуляторе включена агрегация по окнам
+    virtual void onWindow(const WindowSummary& /*window*/) {}
     virtual void onSimulationEnd() = 0; // Для финализации (закрытия файла)
 };
\ No newline at end of file
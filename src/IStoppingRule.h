@@ -0,0 +1,11 @@
+#pragma once
+
+struct SimulationStats;
+
+// Правило досрочной остановки: опрашивается на каждом тике мониторинга,
+// накопленная статистика к этому моменту доведена до текущего времени
+class IStoppingRule {
+public:
+    virtual ~IStoppingRule() = default;
+    virtual bool shouldStop(const SimulationStats& stats, double time) = 0;
+};
@@ -0,0 +1,163 @@
+// === Profiler.h ===
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <cstddef>
+#include <ostream>
+#include <iomanip>
+
+// Счётчики горячего пути симулятора. Собираются только в сборке с
+// -DSIMULATOR_PROFILE=ON (макрос SIMULATOR_PROFILE); без него Profiler —
+// пустой класс с пустыми встраиваемыми методами, и вызовы в цикле событий
+// компилируются в ничто. В профилирующей сборке сбор включается enable().
+
+// Участки цикла событий с замером времени
+enum class ProfileSection {
+    Run,          // весь runUntil
+    Activation,   // обработчик ACTIVATION
+    Deactivation, // обработчик DEACTIVATION
+    Monitoring,   // тик мониторинга (включая слушателей и правило остановки)
+    Listener,     // вызовы слушателей (снимки и окна)
+    Count
+};
+
+// Источники обращений к ГСЧ
+enum class RngSource {
+    Workload,  // объём работы при активации
+    Passive,   // время простоя
+    Service,   // время обслуживания
+    Event,     // момент и тип следующего события агрегированного режима
+               // (без подпотока пользователя при общих случайных числах)
+    Count
+};
+
+#ifdef SIMULATOR_PROFILE
+
+class Profiler {
+    using Clock = std::chrono::steady_clock;
+    static constexpr size_t kSections = static_cast<size_t>(ProfileSection::Count);
+    static constexpr size_t kRngSources = static_cast<size_t>(RngSource::Count);
+
+    bool m_enabled = false;
+    uint64_t m_calls[kSections] = {};
+    uint64_t m_nanos[kSections] = {};
+    uint64_t m_staleEvents = 0;
+    size_t m_queueHighWater = 0;
+    uint64_t m_rngCalls[kRngSources] = {};
+
+    static const char* sectionName(size_t i) {
+        static const char* names[] = {"run", "activation", "deactivation", "monitoring", "listener"};
+        return names[i];
+    }
+    static const char* rngName(size_t i) {
+        static const char* names[] = {"workload", "passive", "service", "event"};
+        return names[i];
+    }
+
+public:
+    static constexpr bool kCompiled = true;
+
+    // Замер участка: время от создания до разрушения
+    class Scope {
+        Profiler* m_profiler;
+        size_t m_section;
+        Clock::time_point m_start;
+    public:
+        Scope(Profiler& profiler, ProfileSection section)
+            : m_profiler(profiler.m_enabled ? &profiler : nullptr),
+              m_section(static_cast<size_t>(section)) {
+            if (m_profiler) m_start = Clock::now();
+        }
+        ~Scope() {
+            if (!m_profiler) return;
+            auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - m_start);
+            m_profiler->m_calls[m_section]++;
+            m_profiler->m_nanos[m_section] += static_cast<uint64_t>(elapsed.count());
+        }
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+    };
+
+    void enable() { m_enabled = true; }
+    bool enabled() const { return m_enabled; }
+
+    void countStale() { if (m_enabled) ++m_staleEvents; }
+    void countRng(RngSource source, uint64_t calls = 1) {
+        if (m_enabled) m_rngCalls[static_cast<size_t>(source)] += calls;
+    }
+    void observeQueue(size_t size) {
+        if (m_enabled && size > m_queueHighWater) m_queueHighWater = size;
+    }
+
+    uint64_t calls(ProfileSection s) const { return m_calls[static_cast<size_t>(s)]; }
+    double seconds(ProfileSection s) const { return m_nanos[static_cast<size_t>(s)] * 1e-9; }
+
+    double staleRatio() const {
+        uint64_t handled = calls(ProfileSection::Activation) + calls(ProfileSection::Deactivation);
+        uint64_t popped = handled + m_staleEvents;
+        return popped ? static_cast<double>(m_staleEvents) / static_cast<double>(popped) : 0.0;
+    }
+
+    void print(std::ostream& out) const {
+        double total = seconds(ProfileSection::Run);
+        out << "\n=== ПРОФИЛЬ ЦИКЛА СОБЫТИЙ ===\n";
+        // Заголовок выровнен вручную: setw считает байты, а не символы UTF-8
+        out << "Участок                вызовов    время, с      доля    нс/вызов\n";
+        for (size_t i = 0; i < kSections; ++i) {
+            double sec = m_nanos[i] * 1e-9;
+            out << std::left << std::setw(16) << sectionName(i) << std::right
+                << std::setw(14) << m_calls[i]
+                << std::setw(12) << std::fixed << std::setprecision(4) << sec
+                << std::setw(9) << std::setprecision(1) << (total > 0.0 ? 100.0 * sec / total : 0.0) << "%"
+                << std::setw(12) << std::setprecision(1)
+                << (m_calls[i] ? static_cast<double>(m_nanos[i]) / static_cast<double>(m_calls[i]) : 0.0)
+                << "\n";
+        }
+        out << "(снимки слушателям входят в monitoring, окна — в run; остаток run — очередь и учёт статистики)\n";
+        out << "Устаревших событий:     " << m_staleEvents
+            << " (" << std::setprecision(2) << 100.0 * staleRatio() << "% извлечённых)\n";
+        out << "Макс. размер очереди:   " << m_queueHighWater << "\n";
+        out << "Обращений к ГСЧ:        ";
+        for (size_t i = 0; i < kRngSources; ++i)
+            out << (i ? ", " : "") << rngName(i) << "=" << m_rngCalls[i];
+        out << "\n";
+        out.unsetf(std::ios::floatfield);
+    }
+
+    void writeJson(std::ostream& out) const {
+        out << "{\n  \"sections\": {\n";
+        for (size_t i = 0; i < kSections; ++i) {
+            out << "    \"" << sectionName(i) << "\": {\"calls\": " << m_calls[i]
+                << ", \"nanoseconds\": " << m_nanos[i] << "}" << (i + 1 < kSections ? "," : "") << "\n";
+        }
+        out << "  },\n  \"stale_events\": " << m_staleEvents
+            << ",\n  \"stale_ratio\": " << std::setprecision(6) << staleRatio()
+            << ",\n  \"queue_high_water\": " << m_queueHighWater
+            << ",\n  \"rng_calls\": {";
+        for (size_t i = 0; i < kRngSources; ++i)
+            out << (i ? ", " : "") << "\"" << rngName(i) << "\": " << m_rngCalls[i];
+        out << "}\n}\n";
+    }
+};
+
+#else
+
+class Profiler {
+public:
+    static constexpr bool kCompiled = false;
+
+    class Scope {
+    public:
+        Scope(Profiler&, ProfileSection) {}
+    };
+
+    void enable() {}
+    bool enabled() const { return false; }
+    void countStale() {}
+    void countRng(RngSource, uint64_t = 1) {}
+    void observeQueue(size_t) {}
+    void print(std::ostream&) const {}
+    void writeJson(std::ostream&) const {}
+};
+
+#endif
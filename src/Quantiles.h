@@ -0,0 +1,303 @@
+// === Quantiles.h ===
+#pragma once
+#include "BinaryIO.h"
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstddef>
+#include <stdexcept>
+#include <istream>
+#include <ostream>
+
+// Потоковые оценки квантилей с ограниченной памятью. Обе структуры
+// сливаются (merge), поэтому оценки по независимым прогонам объединяются.
+
+// Лог-линейная гистограмма (в духе HDR Histogram): каждая октава
+// [2^e, 2^(e+1)) делится на 2^kSubBucketBits равных частей. Относительная
+// ошибка квантиля не превышает 2^-(kSubBucketBits+1) ≈ 0.4%; память
+// фиксирована (~61 КБ) и выделяется при первом добавлении.
+class LogLinearHistogram {
+    static constexpr int kSubBucketBits = 7;
+    static constexpr int kSubBuckets = 1 << kSubBucketBits;
+    static constexpr int kMinExponent = -20;  // меньше 2^-20 ≈ 1e-6 — в нижний бакет
+    static constexpr int kMaxExponent = 40;   // от 2^40 ≈ 1e12 — в верхний бакет
+    static constexpr size_t kBuckets = static_cast<size_t>(kMaxExponent - kMinExponent) * kSubBuckets + 2;
+
+    std::vector<uint64_t> m_counts;
+    uint64_t m_count = 0;
+    double m_sum = 0.0;
+    double m_min = INFINITY;
+    double m_max = -INFINITY;
+
+    static size_t bucketOf(double x) {
+        if (!(x >= std::ldexp(1.0, kMinExponent))) return 0;
+        int e;
+        double m = std::frexp(x, &e);  // x = m·2^e, m ∈ [0.5, 1)
+        int octave = e - 1;
+        if (octave >= kMaxExponent) return kBuckets - 1;
+        int sub = static_cast<int>((2.0 * m - 1.0) * kSubBuckets);
+        return static_cast<size_t>(octave - kMinExponent) * kSubBuckets + static_cast<size_t>(sub) + 1;
+    }
+
+    // Середина бакета (нижний и верхний — по наблюдённым min/max)
+    double bucketMidpoint(size_t index) const {
+        if (index == 0) return m_min;
+        if (index == kBuckets - 1) return m_max;
+        size_t i = index - 1;
+        int octave = static_cast<int>(i / kSubBuckets) + kMinExponent;
+        double width = std::ldexp(1.0, octave - kSubBucketBits);
+        double lower = std::ldexp(1.0, octave) + static_cast<double>(i % kSubBuckets) * width;
+        return lower + 0.5 * width;
+    }
+
+public:
+    void add(double x) {
+        if (m_counts.empty()) m_counts.assign(kBuckets, 0);
+        ++m_counts[bucketOf(x)];
+        ++m_count;
+        m_sum += x;
+        m_min = std::min(m_min, x);
+        m_max = std::max(m_max, x);
+    }
+
+    void merge(const LogLinearHistogram& other) {
+        if (other.m_count == 0) return;
+        if (m_counts.empty()) m_counts.assign(kBuckets, 0);
+        for (size_t i = 0; i < kBuckets; ++i) m_counts[i] += other.m_counts[i];
+        m_count += other.m_count;
+        m_sum += other.m_sum;
+        m_min = std::min(m_min, other.m_min);
+        m_max = std::max(m_max, other.m_max);
+    }
+
+    uint64_t count() const { return m_count; }
+    double mean() const { return m_count ? m_sum / static_cast<double>(m_count) : 0.0; }
+
+    double quantile(double q) const {
+        if (m_count == 0) return 0.0;
+        uint64_t rank = static_cast<uint64_t>(std::ceil(std::clamp(q, 0.0, 1.0) * static_cast<double>(m_count)));
+        rank = std::max<uint64_t>(rank, 1);
+        uint64_t seen = 0;
+        for (size_t i = 0; i < kBuckets; ++i) {
+            seen += m_counts[i];
+            if (seen >= rank) return std::clamp(bucketMidpoint(i), m_min, m_max);
+        }
+        return m_max;
+    }
+
+    void save(std::ostream& out) const {
+        BinaryIO::write(out, m_count);
+        BinaryIO::write(out, m_sum);
+        BinaryIO::write(out, m_min);
+        BinaryIO::write(out, m_max);
+        // Только ненулевые бакеты: (индекс, счётчик)
+        std::vector<uint64_t> sparse;
+        for (size_t i = 0; i < m_counts.size(); ++i) {
+            if (m_counts[i] == 0) continue;
+            sparse.push_back(i);
+            sparse.push_back(m_counts[i]);
+        }
+        BinaryIO::writeVector(out, sparse);
+    }
+
+    void load(std::istream& in) {
+        m_count = BinaryIO::read<uint64_t>(in);
+        m_sum = BinaryIO::read<double>(in);
+        m_min = BinaryIO::read<double>(in);
+        m_max = BinaryIO::read<double>(in);
+        auto sparse = BinaryIO::readVector<uint64_t>(in);
+        m_counts.clear();
+        if (m_count > 0) m_counts.assign(kBuckets, 0);
+        for (size_t i = 0; i + 1 < sparse.size(); i += 2) {
+            if (sparse[i] >= kBuckets) throw std::runtime_error("Corrupted histogram bucket index");
+            m_counts[sparse[i]] = sparse[i + 1];
+        }
+    }
+};
+
+// Сливающийся t-digest (Dunning, Ertl): центроиды с масштабной функцией
+// k1(q) = δ/(2π)·asin(2q−1), точнее всего на хвостах. Число центроидов
+// порядка δ, новые точки копятся в буфере и вливаются пакетом.
+class TDigest {
+    struct Centroid {
+        double mean;
+        double weight;
+    };
+
+    static constexpr double kPi = 3.14159265358979323846;
+
+    double m_compression;
+    std::vector<Centroid> m_centroids;  // упорядочены по mean
+    std::vector<Centroid> m_buffer;
+    double m_totalWeight = 0.0;
+    double m_sum = 0.0;
+    double m_min = INFINITY;
+    double m_max = -INFINITY;
+
+    double k(double q) const { return m_compression / (2.0 * kPi) * std::asin(2.0 * q - 1.0); }
+    double kInverse(double value) const { return (std::sin(value * 2.0 * kPi / m_compression) + 1.0) / 2.0; }
+
+    void compress() {
+        if (m_buffer.empty()) return;
+        m_buffer.insert(m_buffer.end(), m_centroids.begin(), m_centroids.end());
+        std::sort(m_buffer.begin(), m_buffer.end(),
+                  [](const Centroid& a, const Centroid& b) { return a.mean < b.mean; });
+
+        m_centroids.clear();
+        Centroid current = m_buffer.front();
+        double q0 = 0.0;
+        double qLimit = kInverse(k(q0) + 1.0);
+        for (size_t i = 1; i < m_buffer.size(); ++i) {
+            const Centroid& next = m_buffer[i];
+            double q = q0 + (current.weight + next.weight) / m_totalWeight;
+            if (q <= qLimit) {
+                current.weight += next.weight;
+                current.mean += (next.mean - current.mean) * next.weight / current.weight;
+            } else {
+                m_centroids.push_back(current);
+                q0 += current.weight / m_totalWeight;
+                qLimit = kInverse(k(q0) + 1.0);
+                current = next;
+            }
+        }
+        m_centroids.push_back(current);
+        m_buffer.clear();
+    }
+
+public:
+    explicit TDigest(double compression = 1000.0) : m_compression(compression) {}
+
+    void add(double x, double weight = 1.0) {
+        m_buffer.push_back({x, weight});
+        m_totalWeight += weight;
+        m_sum += x * weight;
+        m_min = std::min(m_min, x);
+        m_max = std::max(m_max, x);
+        if (m_buffer.size() >= static_cast<size_t>(5 * m_compression)) compress();
+    }
+
+    void merge(const TDigest& other) {
+        if (other.m_totalWeight == 0.0) return;
+        m_buffer.insert(m_buffer.end(), other.m_centroids.begin(), other.m_centroids.end());
+        m_buffer.insert(m_buffer.end(), other.m_buffer.begin(), other.m_buffer.end());
+        m_totalWeight += other.m_totalWeight;
+        m_sum += other.m_sum;
+        m_min = std::min(m_min, other.m_min);
+        m_max = std::max(m_max, other.m_max);
+        compress();
+    }
+
+    uint64_t count() const { return static_cast<uint64_t>(m_totalWeight); }
+    double mean() const { return m_totalWeight > 0.0 ? m_sum / m_totalWeight : 0.0; }
+
+    double quantile(double q) const {
+        if (m_totalWeight == 0.0) return 0.0;
+        if (!m_buffer.empty()) {
+            TDigest merged = *this;
+            merged.compress();
+            return merged.quantile(q);
+        }
+        if (m_centroids.size() == 1) return m_centroids.front().mean;
+
+        double target = std::clamp(q, 0.0, 1.0) * m_totalWeight;
+        // Центр центроида i — в точке накопленного веса cum_i + w_i/2
+        double cumulative = 0.0;
+        double prevCenter = 0.0, prevMean = m_min;
+        for (const auto& c : m_centroids) {
+            double center = cumulative + c.weight / 2.0;
+            if (target < center) {
+                double span = center - prevCenter;
+                double t = span > 0.0 ? (target - prevCenter) / span : 0.0;
+                return prevMean + t * (c.mean - prevMean);
+            }
+            cumulative += c.weight;
+            prevCenter = center;
+            prevMean = c.mean;
+        }
+        double span = m_totalWeight - prevCenter;
+        double t = span > 0.0 ? (target - prevCenter) / span : 1.0;
+        return prevMean + t * (m_max - prevMean);
+    }
+
+    void save(std::ostream& out) const {
+        TDigest merged = *this;
+        merged.compress();
+        BinaryIO::write(out, merged.m_compression);
+        BinaryIO::write(out, merged.m_totalWeight);
+        BinaryIO::write(out, merged.m_sum);
+        BinaryIO::write(out, merged.m_min);
+        BinaryIO::write(out, merged.m_max);
+        BinaryIO::write<uint64_t>(out, merged.m_centroids.size());
+        for (const auto& c : merged.m_centroids) {
+            BinaryIO::write(out, c.mean);
+            BinaryIO::write(out, c.weight);
+        }
+    }
+
+    void load(std::istream& in) {
+        m_compression = BinaryIO::read<double>(in);
+        m_totalWeight = BinaryIO::read<double>(in);
+        m_sum = BinaryIO::read<double>(in);
+        m_min = BinaryIO::read<double>(in);
+        m_max = BinaryIO::read<double>(in);
+        m_centroids.resize(BinaryIO::read<uint64_t>(in));
+        for (auto& c : m_centroids) {
+            c.mean = BinaryIO::read<double>(in);
+            c.weight = BinaryIO::read<double>(in);
+        }
+        m_buffer.clear();
+    }
+};
+
+// Способ оценки квантилей времени отклика
+enum class QuantileMethod {
+    Hdr,     // лог-линейная гистограмма: O(1) на значение, ошибка ≤ 0.4%
+    TDigest  // t-digest: точнее на крайних хвостах, дороже на добавление
+};
+
+// Квантили времени отклика выбранным методом; вторая структура не используется
+// и памяти не занимает
+class LatencyQuantiles {
+    QuantileMethod m_method;
+    LogLinearHistogram m_hdr;
+    TDigest m_digest;
+
+public:
+    explicit LatencyQuantiles(QuantileMethod method = QuantileMethod::Hdr) : m_method(method) {}
+
+    QuantileMethod method() const { return m_method; }
+    const char* methodName() const { return m_method == QuantileMethod::Hdr ? "HDR" : "t-digest"; }
+
+    void add(double x) {
+        if (m_method == QuantileMethod::Hdr) m_hdr.add(x);
+        else m_digest.add(x);
+    }
+
+    void merge(const LatencyQuantiles& other) {
+        if (other.m_method != m_method) throw std::invalid_argument("Cannot merge quantiles of different methods");
+        m_hdr.merge(other.m_hdr);
+        m_digest.merge(other.m_digest);
+    }
+
+    uint64_t count() const { return m_method == QuantileMethod::Hdr ? m_hdr.count() : m_digest.count(); }
+    double mean() const { return m_method == QuantileMethod::Hdr ? m_hdr.mean() : m_digest.mean(); }
+    double quantile(double q) const {
+        return m_method == QuantileMethod::Hdr ? m_hdr.quantile(q) : m_digest.quantile(q);
+    }
+
+    void save(std::ostream& out) const {
+        BinaryIO::write<int32_t>(out, static_cast<int32_t>(m_method));
+        if (m_method == QuantileMethod::Hdr) m_hdr.save(out);
+        else m_digest.save(out);
+    }
+
+    // Метод задаётся при создании; сохранённый другим методом не загружается
+    void load(std::istream& in) {
+        if (static_cast<QuantileMethod>(BinaryIO::read<int32_t>(in)) != m_method)
+            throw std::runtime_error("Saved latency quantiles use a different method");
+        if (m_method == QuantileMethod::Hdr) m_hdr.load(in);
+        else m_digest.load(in);
+    }
+};
@@ -1,43 +1,400 @@
 #include "RandomGenerator.h"
 #include <stdexcept>
 #include <random>
+#include <cmath>
 
-RandomGenerator::RandomGenerator() 
-    : seed_(std::random_device{}()), gen_(seed_) {}
+namespace {
+
+uint64_t splitMix64(uint64_t& x) {
+    uint64_t z = (x += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+const char* engineName(RngEngine engine) {
+    return engine == RngEngine::Xoshiro256pp ? "xoshiro256pp" : "philox4x32";
+}
+
+// Таблицы зиккурата (Marsaglia, Tsang 2000; вариант с double по Doornik 2005).
+// x[0] — ширина основания, x[1] = R, ..., x[C] = 0; ratio[i] = x[i+1] / x[i].
+template <int C>
+struct ZigguratTable {
+    double x[C + 1];
+    double ratio[C];
+};
+
+ZigguratTable<128> makeNormalTable() {
+    const double R = 3.442619855899, V = 9.91256303526217e-3;
+    ZigguratTable<128> t;
+    double f = std::exp(-0.5 * R * R);
+    t.x[0] = V / f;
+    t.x[1] = R;
+    t.x[128] = 0.0;
+    for (int i = 2; i < 128; ++i) {
+        t.x[i] = std::sqrt(-2.0 * std::log(V / t.x[i - 1] + f));
+        f = std::exp(-0.5 * t.x[i] * t.x[i]);
+    }
+    for (int i = 0; i < 128; ++i) t.ratio[i] = t.x[i + 1] / t.x[i];
+    return t;
+}
+
+ZigguratTable<256> makeExponentialTable() {
+    const double R = 7.69711747013104972, V = 3.949659822581572e-3;
+    ZigguratTable<256> t;
+    double f = std::exp(-R);
+    t.x[0] = V / f;
+    t.x[1] = R;
+    t.x[256] = 0.0;
+    for (int i = 2; i < 256; ++i) {
+        t.x[i] = -std::log(V / t.x[i - 1] + f);
+        f = std::exp(-t.x[i]);
+    }
+    for (int i = 0; i < 256; ++i) t.ratio[i] = t.x[i + 1] / t.x[i];
+    return t;
+}
+
+const ZigguratTable<128>& normalTable() {
+    static const ZigguratTable<128> table = makeNormalTable();
+    return table;
+}
+
+const ZigguratTable<256>& exponentialTable() {
+    static const ZigguratTable<256> table = makeExponentialTable();
+    return table;
+}
+
+} // namespace
+
+// === xoshiro256++ ===
+
+void Xoshiro256pp::reseed(uint64_t seed) {
+    // Расширение 64-битного семени через SplitMix64, как рекомендуют авторы
+    uint64_t x = seed;
+    for (auto& word : s) word = splitMix64(x);
+}
+
+void Xoshiro256pp::jump() {
+    static const uint64_t JUMP[] = {
+        0x180ec6d33cfd0abaull, 0xd5a61266f0c9392cull,
+        0xa9582618e03fc9aaull, 0x39abdc4529b1661cull
+    };
+    uint64_t t[4] = {0, 0, 0, 0};
+    for (uint64_t word : JUMP) {
+        for (int b = 0; b < 64; ++b) {
+            if (word & (uint64_t(1) << b)) {
+                for (int i = 0; i < 4; ++i) t[i] ^= s[i];
+            }
+            next();
+        }
+    }
+    for (int i = 0; i < 4; ++i) s[i] = t[i];
+}
+
+// === Philox4x32-10 ===
+
+void Philox4x32::generateBlock(uint64_t block) {
+    uint32_t ctr[4] = {
+        static_cast<uint32_t>(block), static_cast<uint32_t>(block >> 32),
+        static_cast<uint32_t>(stream_), static_cast<uint32_t>(stream_ >> 32)
+    };
+    uint32_t key[2] = {key_[0], key_[1]};
+
+    for (int round = 0; round < 10; ++round) {
+        uint64_t p0 = static_cast<uint64_t>(0xD2511F53u) * ctr[0];
+        uint64_t p1 = static_cast<uint64_t>(0xCD9E8D57u) * ctr[2];
+        uint32_t next[4] = {
+            static_cast<uint32_t>(p1 >> 32) ^ ctr[1] ^ key[0],
+            static_cast<uint32_t>(p1),
+            static_cast<uint32_t>(p0 >> 32) ^ ctr[3] ^ key[1],
+            static_cast<uint32_t>(p0)
+        };
+        for (int i = 0; i < 4; ++i) ctr[i] = next[i];
+        key[0] += 0x9E3779B9u;
+        key[1] += 0xBB67AE85u;
+    }
+    for (int i = 0; i < 4; ++i) out_[i] = ctr[i];
+}
+
+// === RandomGenerator ===
+
+RandomGenerator::RandomGenerator()
+    : RandomGenerator((static_cast<uint64_t>(std::random_device{}()) << 32) | std::random_device{}()) {}
+
+RandomGenerator::RandomGenerator(uint64_t seed, RngEngine engine)
+    : engine_(engine) {
+    setSeed(seed);
+}
+
+RandomGenerator RandomGenerator::stream(uint64_t index) const {
+    RandomGenerator result(seed_, engine_);
+    result.streamIndex_ = index;
+    if (engine_ == RngEngine::Philox4x32) {
+        result.philox_ = Philox4x32(seed_, index);
+    } else {
+        for (uint64_t i = 0; i < index; ++i) result.xoshiro_.jump();
+    }
+    return result;
+}
+
+RandomGenerator RandomGenerator::substream(uint64_t index) const {
+    if (index >> 32) throw std::out_of_range("Substream index must be below 2^32");
+    RandomGenerator result = *this;
+    result.streamIndex_ = ((streamIndex_ + 1) << 32) | index;
+    if (engine_ == RngEngine::Philox4x32) {
+        result.philox_ = Philox4x32(seed_, result.streamIndex_);
+    } else {
+        uint64_t mix = result.streamIndex_;
+        result.xoshiro_.reseed(seed_ ^ splitMix64(mix));
+    }
+    return result;
+}
+
+namespace {
+
+// Источник бит антитетического потока: биты движка с инверсией
+template <class Bits>
+struct Flipped {
+    Bits& bits;
+    uint64_t next() { return ~bits.next(); }
+};
+
+template <class Bits>
+double uniformFrom(Bits& bits) {
+    return static_cast<double>(bits.next() >> 11) * 0x1.0p-53;
+}
+
+// Ядра шаблонны по источнику бит: пакетные заполнители выбирают движок
+// один раз на пакет, и внутренний цикл идёт по конкретному движку
+template <class Bits>
+double zigguratExponential(Bits& bits) {
+    static const double R = 7.69711747013104972;
+    const auto& t = exponentialTable();
+    for (;;) {
+        // Младшие 8 бит — номер слоя, старшие 53 — равномерная координата
+        uint64_t b = bits.next();
+        int i = static_cast<int>(b & 0xFF);
+        double u = static_cast<double>(b >> 11) * 0x1.0p-53;
+        if (u < t.ratio[i]) return u * t.x[i];
+        if (i == 0) return R - std::log1p(-uniformFrom(bits));  // хвост: отсутствие памяти
+        double x = u * t.x[i];
+        double f0 = std::exp(x - t.x[i]);
+        double f1 = std::exp(x - t.x[i + 1]);
+        if (f1 + uniformFrom(bits) * (f0 - f1) < 1.0) return x;
+    }
+}
+
+template <class Bits>
+double zigguratNormal(Bits& bits) {
+    static const double R = 3.442619855899;
+    const auto& t = normalTable();
+    for (;;) {
+        // Младшие 7 бит — номер слоя, старшие 53 — координата со знаком в [-1, 1)
+        uint64_t b = bits.next();
+        int i = static_cast<int>(b & 0x7F);
+        double u = static_cast<double>(static_cast<int64_t>(b) >> 11) * 0x1.0p-52;
+        if (std::abs(u) < t.ratio[i]) return u * t.x[i];
+        if (i == 0) {
+            // Хвост за R (Marsaglia 1964)
+            double x, y;
+            do {
+                x = std::log1p(-uniformFrom(bits)) / R;
+                y = std::log1p(-uniformFrom(bits));
+            } while (-2.0 * y < x * x);
+            return u < 0.0 ? x - R : R - x;
+        }
+        double x = u * t.x[i];
+        double f0 = std::exp(-0.5 * (t.x[i] * t.x[i] - x * x));
+        double f1 = std::exp(-0.5 * (t.x[i + 1] * t.x[i + 1] - x * x));
+        if (f1 + uniformFrom(bits) * (f0 - f1) < 1.0) return x;
+    }
+}
+
+// Marsaglia, Tsang 2000: "A simple method for generating gamma variables"; shape >= 1
+template <class Bits>
+double marsagliaTsangGamma(Bits& bits, double d, double c) {
+    for (;;) {
+        double x, v;
+        do {
+            x = zigguratNormal(bits);
+            v = 1.0 + c * x;
+        } while (v <= 0.0);
+        v = v * v * v;
+        double u = uniformFrom(bits);
+        double x2 = x * x;
+        if (u < 1.0 - 0.0331 * x2 * x2) return d * v;
+        if (std::log(u) < 0.5 * x2 + d * (1.0 - v + std::log(v))) return d * v;
+    }
+}
+
+template <class Bits>
+double gammaFrom(Bits& bits, double shape) {
+    if (shape < 1.0) {
+        // Gamma(a) = Gamma(a + 1) · U^(1/a)
+        double u = uniformFrom(bits);
+        double a = shape + 1.0 - 1.0 / 3.0;
+        return marsagliaTsangGamma(bits, a, 1.0 / std::sqrt(9.0 * a)) * std::pow(u, 1.0 / shape);
+    }
+    double d = shape - 1.0 / 3.0;
+    return marsagliaTsangGamma(bits, d, 1.0 / std::sqrt(9.0 * d));
+}
+
+} // namespace
+
+template <class Fill>
+void RandomGenerator::withEngine(Fill&& fill) {
+    if (flip_) {
+        if (engine_ == RngEngine::Xoshiro256pp) {
+            Flipped<Xoshiro256pp> bits{xoshiro_};
+            fill(bits);
+        } else {
+            Flipped<Philox4x32> bits{philox_};
+            fill(bits);
+        }
+    } else {
+        withRawEngine(fill);
+    }
+}
+
+template <class Fill>
+void RandomGenerator::withRawEngine(Fill&& fill) {
+    if (engine_ == RngEngine::Xoshiro256pp) {
+        fill(xoshiro_);
+    } else {
+        fill(philox_);
+    }
+}
+
+double RandomGenerator::standardExponential() {
+    if (inverse_) return -std::log1p(-uniform01());
+    double value = 0.0;
+    withEngine([&](auto& bits) { value = zigguratExponential(bits); });
+    return value;
+}
+
+double RandomGenerator::standardNormal() {
+    double value = 0.0;
+    withRawEngine([&](auto& bits) { value = zigguratNormal(bits); });
+    return flip_ ? -value : value;
+}
+
+double RandomGenerator::standardGamma(double shape) {
+    if (shape <= 0.0) throw std::invalid_argument("Gamma shape must be > 0");
+    double value = 0.0;
+    withEngine([&](auto& bits) { value = gammaFrom(bits, shape); });
+    return value;
+}
+
+void RandomGenerator::fillUniform01(double* out, size_t n) {
+    withEngine([&](auto& bits) {
+        for (size_t i = 0; i < n; ++i) out[i] = uniformFrom(bits);
+    });
+}
+
+void RandomGenerator::fillStandardExponential(double* out, size_t n) {
+    if (inverse_) {
+        for (size_t i = 0; i < n; ++i) out[i] = -std::log1p(-uniform01());
+        return;
+    }
+    withEngine([&](auto& bits) {
+        for (size_t i = 0; i < n; ++i) out[i] = zigguratExponential(bits);
+    });
+}
+
+void RandomGenerator::fillStandardNormal(double* out, size_t n) {
+    withRawEngine([&](auto& bits) {
+        for (size_t i = 0; i < n; ++i) out[i] = zigguratNormal(bits);
+    });
+    if (flip_) {
+        for (size_t i = 0; i < n; ++i) out[i] = -out[i];
+    }
+}
+
+void RandomGenerator::fillStandardGamma(double shape, double* out, size_t n) {
+    if (shape <= 0.0) throw std::invalid_argument("Gamma shape must be > 0");
+    withEngine([&](auto& bits) {
+        for (size_t i = 0; i < n; ++i) out[i] = gammaFrom(bits, shape);
+    });
+}
 
 double RandomGenerator::uniform(double a, double b) {
-    std::uniform_real_distribution<double> dist(a, b);
-    return dist(gen_);
+    return a + (b - a) * uniform01();
 }
 
 double RandomGenerator::exponential(double rate) {
     if (rate <= 0.0) throw std::invalid_argument("Rate must be > 0");
-    std::exponential_distribution<double> dist(rate);
-    return dist(gen_);
+    return standardExponential() / rate;
 }
 
 int RandomGenerator::integer(int min, int max) {
     if (min > max) throw std::invalid_argument("Invalid range");
     std::uniform_int_distribution<int> dist(min, max);
-    return dist(gen_);
+    return dist(*this);
 }
 
-void RandomGenerator::setSeed(unsigned int seed) {
+double RandomGenerator::normal(double mean, double stddev) {
+    return mean + stddev * standardNormal();
+}
+
+double RandomGenerator::gamma(double shape, double scale) {
+    return scale * standardGamma(shape);
+}
+
+double RandomGenerator::lognormal(double mu, double sigma) {
+    return std::exp(mu + sigma * standardNormal());
+}
+
+void RandomGenerator::setSeed(uint64_t seed) {
     seed_ = seed;
-    gen_.seed(seed);
+    streamIndex_ = 0;
+    xoshiro_.reseed(seed);
+    philox_ = Philox4x32(seed, 0);
 }
 
-unsigned int RandomGenerator::getSeed() const {
+uint64_t RandomGenerator::getSeed() const {
     return seed_;  // Возвращаем сохранённое семя, а не пытаемся извлечь из генератора
 }
 
 std::string RandomGenerator::getState() const {
     std::ostringstream oss;
-    oss << gen_;  // Сериализация полного состояния генератора
+    oss << engineName(engine_) << ' ' << seed_ << ' ' << streamIndex_;
+    if (engine_ == RngEngine::Xoshiro256pp) {
+        for (uint64_t word : xoshiro_.s) oss << ' ' << word;
+    } else {
+        // Буфер out_ восстанавливается пересчётом блока, поэтому хранится только позиция
+        oss << ' ' << philox_.block_ << ' ' << philox_.index_;
+    }
     return oss.str();
 }
 
 void RandomGenerator::setState(const std::string& state) {
     std::istringstream iss(state);
-    iss >> gen_;  // Десериализация
-}
\ No newline at end of file
+    std::string name;
+    uint64_t seed = 0, stream = 0;
+    if (!(iss >> name >> seed >> stream)) throw std::invalid_argument("Invalid RNG state");
+
+    if (name == engineName(RngEngine::Xoshiro256pp)) {
+        Xoshiro256pp x;
+        for (auto& word : x.s) {
+            if (!(iss >> word)) throw std::invalid_argument("Invalid xoshiro256++ state");
+        }
+        engine_ = RngEngine::Xoshiro256pp;
+        xoshiro_ = x;
+        philox_ = Philox4x32(seed, stream);
+    } else if (name == engineName(RngEngine::Philox4x32)) {
+        Philox4x32 p(seed, stream);
+        if (!(iss >> p.block_ >> p.index_) || p.index_ < 0 || p.index_ > 4)
+            throw std::invalid_argument("Invalid Philox state");
+        if (p.index_ < 4) {
+            if (p.block_ == 0) throw std::invalid_argument("Invalid Philox state");
+            p.generateBlock(p.block_ - 1);
+        }
+        engine_ = RngEngine::Philox4x32;
+        philox_ = p;
+        xoshiro_.reseed(seed);
+    } else {
+        throw std::invalid_argument("Unknown RNG engine: " + name);
+    }
+    seed_ = seed;
+    streamIndex_ = stream;
+}
@@ -4,63 +4,155 @@
 #include <random>
 #include <string>
 #include <sstream>
+#include <cstdint>
+#include <limits>
+#include <cstddef>
 
+// Базовый генератор случайных бит
+enum class RngEngine {
+    Xoshiro256pp,  // xoshiro256++: 32 байта состояния, jump() на 2^128 шагов
+    Philox4x32     // Philox4x32-10: счётчиковый, поток задаётся ключом счётчика за O(1)
+};
+
+// xoshiro256++ (Blackman, Vigna)
+class Xoshiro256pp {
+public:
+    explicit Xoshiro256pp(uint64_t seed = 0) { reseed(seed); }
+
+    void reseed(uint64_t seed);
+
+    uint64_t next() {
+        const uint64_t result = rotl(s[0] + s[3], 23) + s[0];
+        const uint64_t t = s[1] << 17;
+        s[2] ^= s[0];
+        s[3] ^= s[1];
+        s[1] ^= s[2];
+        s[0] ^= s[3];
+        s[2] ^= t;
+        s[3] = rotl(s[3], 45);
+        return result;
+    }
+
+    // Сдвиг на 2^128 шагов: последовательные jump() дают непересекающиеся подпотоки
+    void jump();
+
+    uint64_t s[4];
+
+private:
+    static uint64_t rotl(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+};
+
+// Philox4x32-10 (Salmon et al., "Parallel random numbers: as easy as 1, 2, 3").
+// Счётчик 128 бит: младшие 64 — номер блока, старшие 64 — номер потока,
+// поэтому потоки с разными номерами заведомо не пересекаются.
+class Philox4x32 {
+public:
+    explicit Philox4x32(uint64_t seed = 0, uint64_t stream = 0)
+        : key_{static_cast<uint32_t>(seed), static_cast<uint32_t>(seed >> 32)}, stream_(stream) {}
+
+    uint64_t next() {
+        if (index_ >= 4) {
+            generateBlock(block_++);
+            index_ = 0;
+        }
+        uint64_t value = (static_cast<uint64_t>(out_[index_]) << 32) | out_[index_ + 1];
+        index_ += 2;
+        return value;
+    }
+
+    void generateBlock(uint64_t block);
+
+    uint32_t key_[2];
+    uint64_t stream_ = 0;
+    uint64_t block_ = 0;   // следующий блок к генерации
+    uint32_t out_[4] = {0, 0, 0, 0};
+    int index_ = 4;        // позиция в out_; 4 — блок исчерпан
+};
+
+// Генератор случайных величин одной симуляции (не синглтон).
+// Передаётся в Simulator и в Distribution::sample; копирование
+// даёт независимую копию состояния.
 class RandomGenerator {
 public:
-    // Единая точка доступа (Singleton через статический метод)
-    static RandomGenerator& instance() {
-        static RandomGenerator instance;
-        return instance;
+    // Интерфейс UniformRandomBitGenerator (для std::*_distribution)
+    using result_type = uint64_t;
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return std::numeric_limits<uint64_t>::max(); }
+
+    RandomGenerator();  // семя из std::random_device
+    explicit RandomGenerator(uint64_t seed, RngEngine engine = RngEngine::Xoshiro256pp);
+
+    result_type operator()() {
+        return (engine_ == RngEngine::Xoshiro256pp ? xoshiro_.next() : philox_.next()) ^ flip_;
     }
 
-    // Запрещаем копирование
-    RandomGenerator(const RandomGenerator&) = delete;
-    RandomGenerator& operator=(const RandomGenerator&) = delete;
+    // Независимый подпоток с номером index (поток 0 совпадает с исходным генератором).
+    // Philox: O(1). Xoshiro: index вызовов jump() от начального состояния.
+    RandomGenerator stream(uint64_t index) const;
+
+    // Подпоток index < 2^32 текущего потока за O(1) (общие случайные числа:
+    // свой подпоток на пользователя и величину). Philox: номер потока
+    // (поток + 1)·2^32 + index, с потоками stream() не пересекается.
+    // Xoshiro: состояние из SplitMix64 от семени и номера — случайная точка
+    // периода 2^256. Антитетический режим наследуется
+    RandomGenerator substream(uint64_t index) const;
+
+    // Экспонента обращением функции распределения, −ln(1 − U), вместо
+    // зиккурата: медленнее, но монотонна по U, что нужно антитетическим
+    // парам. Наследуется подпотоками
+    void setInverseTransform(bool enabled) { inverse_ = enabled; }
+    bool inverseTransform() const { return inverse_; }
+
+    // Антитетический поток: случайные биты инвертируются, U превращается
+    // в 1 − U, нормальная величина — в −Z (её зиккурат берёт исходные биты).
+    // С setInverseTransform экспонента, фазовые и равномерные величины
+    // образуют точные антитетические пары с неинвертированным потоком;
+    // зиккурат экспоненты и отбор в гамма-генераторе корреляции не дают
+    void setAntithetic(bool enabled) { flip_ = enabled ? ~uint64_t(0) : 0; }
+    bool antithetic() const { return flip_ != 0; }
 
     // Генерация случайных величин
+    double uniform01() {                // [0, 1), 53 бита
+        return static_cast<double>((*this)() >> 11) * 0x1.0p-53;
+    }
+    double standardExponential();       // Exp(1), зиккурат (256 слоёв)
+    double standardNormal();            // N(0,1), зиккурат (128 слоёв)
+    double standardGamma(double shape); // Gamma(shape, 1), Marsaglia–Tsang
+
+    // Пакетное заполнение: движок выбирается один раз на пакет
+    void fillUniform01(double* out, size_t n);
+    void fillStandardExponential(double* out, size_t n);
+    void fillStandardNormal(double* out, size_t n);
+    void fillStandardGamma(double shape, double* out, size_t n);
     double uniform(double a = 0.0, double b = 1.0);
-    double exponential(double rate);  // rate = λ, среднее = 1/λ
-    int    integer(int min, int max); // включительно [min, max]
+    double exponential(double rate);    // rate = λ, среднее = 1/λ
+    int    integer(int min, int max);   // включительно [min, max]
+    double normal(double mean, double stddev);
+    double gamma(double shape, double scale);
+    double lognormal(double mu, double sigma);
 
     // Установка/получение семени для воспроизводимости
-    void setSeed(unsigned int seed);
-    unsigned int getSeed() const;  // Возвращает ИСХОДНОЕ семя
+    void setSeed(uint64_t seed);
+    uint64_t getSeed() const;  // Возвращает ИСХОДНОЕ семя
+    RngEngine engine() const { return engine_; }
 
     // Полная сериализация состояния (для воспроизводимости промежуточных состояний)
     std::string getState() const;
     void setState(const std::string& state);
 
-    // Публичный доступ к генератору для новых распределений
-    std::mt19937& generator() { return gen_; }
-
 private:
-    RandomGenerator(); // приватный конструктор
-    unsigned int seed_;  // Явно сохраняем семя
-    std::mt19937 gen_;
-};
-
-// Глобальные удобные псевдонимы
-inline double randUniform(double a = 0.0, double b = 1.0) {
-    return RandomGenerator::instance().uniform(a, b);
-}
+    template <class Fill>
+    void withEngine(Fill&& fill);
+    template <class Fill>
+    void withRawEngine(Fill&& fill);
 
-inline double randExponential(double rate) {
-    return RandomGenerator::instance().exponential(rate);
-}
-
-inline double randNormal(double mean, double stddev) {
-    std::normal_distribution<double> dist(mean, stddev);
-    return dist(RandomGenerator::instance().generator());
-}
-
-inline double randGamma(double shape, double scale) {
-    std::gamma_distribution<double> dist(shape, scale);
-    return dist(RandomGenerator::instance().generator());
-}
-
-inline double randLognormal(double mu, double sigma) {
-    std::lognormal_distribution<double> dist(mu, sigma);
-    return dist(RandomGenerator::instance().generator());
-}
+    RngEngine engine_ = RngEngine::Xoshiro256pp;
+    uint64_t seed_ = 0;     // Явно сохраняем семя
+    uint64_t streamIndex_ = 0;
+    uint64_t flip_ = 0;     // маска инверсии бит антитетического потока
+    bool inverse_ = false;  // экспонента обращением функции распределения
+    Xoshiro256pp xoshiro_;
+    Philox4x32 philox_;
+};
 
-#endif // RANDOM_GENERATOR_H
\ No newline at end of file
+#endif // RANDOM_GENERATOR_H
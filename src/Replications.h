@@ -0,0 +1,98 @@
+// === Replications.h ===
+#pragma once
+#include "Simulator.h"
+#include "Statistics.h"
+
+#include <vector>
+#include <string>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+
+// Сводка по R независимым прогонам одного сценария: средние и 95% ДИ.
+// Прогоны добавляются в порядке их номеров, поэтому итог побитово
+// одинаков при любом числе потоков.
+class ReplicationSummary {
+    int m_users;
+    std::vector<double> m_utilization;
+    std::vector<double> m_avgActiveTime;
+    std::vector<double> m_avgPassiveTime;
+    std::vector<double> m_avgTaskCount;
+    std::vector<double> m_maxConcurrent;
+    std::vector<double> m_events;
+    std::vector<std::vector<double>> m_pk;  // [k][прогон]
+    LatencyQuantiles m_completionTime;      // объединённые по всем прогонам
+
+public:
+    explicit ReplicationSummary(int users, QuantileMethod quantiles = QuantileMethod::Hdr)
+        : m_users(users), m_pk(users + 1), m_completionTime(quantiles) {}
+
+    void add(const SimulationStats& stats) {
+        m_utilization.push_back(stats.getNodeUtilization(m_users));
+        m_avgActiveTime.push_back(stats.getAvgActiveTime());
+        m_avgPassiveTime.push_back(stats.getAvgPassiveTime());
+        m_avgTaskCount.push_back(stats.getAvgTaskCount());
+        m_maxConcurrent.push_back(stats.maxConcurrentUsers);
+        m_events.push_back(stats.totalEventsProcessed);
+        m_completionTime.merge(stats.completionTime);
+
+        auto pk = stats.getProbabilityDistribution();
+        for (size_t k = 0; k < m_pk.size(); ++k) {
+            m_pk[k].push_back(k < pk.size() ? pk[k] : 0.0);
+        }
+    }
+
+    size_t count() const { return m_utilization.size(); }
+
+    Stats::MeanCI utilization() const { return Stats::meanCI(m_utilization); }
+    Stats::MeanCI avgActiveTime() const { return Stats::meanCI(m_avgActiveTime); }
+    Stats::MeanCI avgPassiveTime() const { return Stats::meanCI(m_avgPassiveTime); }
+    Stats::MeanCI avgTaskCount() const { return Stats::meanCI(m_avgTaskCount); }
+
+    const LatencyQuantiles& completionTime() const { return m_completionTime; }
+
+    std::vector<Stats::MeanCI> probabilityDistribution() const {
+        std::vector<Stats::MeanCI> result;
+        result.reserve(m_pk.size());
+        for (const auto& values : m_pk) result.push_back(Stats::meanCI(values));
+        return result;
+    }
+
+    std::vector<double> meanProbabilityDistribution() const {
+        std::vector<double> result;
+        for (const auto& ci : probabilityDistribution()) result.push_back(ci.mean);
+        return result;
+    }
+
+    void printSummary() const {
+        auto line = [](const char* label, const Stats::MeanCI& ci, int precision) {
+            std::cout << label << std::fixed << std::setprecision(precision)
+                      << ci.mean << " ± " << ci.halfWidth << "\n";
+        };
+
+        std::cout << "\n=== Результаты " << count() << " независимых прогонов (95% ДИ) ===\n";
+        std::cout << "Число пользователей:    " << m_users << "\n";
+        line("Загрузка узла (ρ):      ", utilization(), 4);
+        line("Максимум активных:      ", Stats::meanCI(m_maxConcurrent), 1);
+        line("Среднее время активности: ", avgActiveTime(), 3);
+        line("Среднее время простоя:  ", avgPassiveTime(), 3);
+        line("Среднее число задач:    ", avgTaskCount(), 1);
+        line("Обработано событий:     ", Stats::meanCI(m_events), 0);
+        SimulationStats::printCompletionTime(m_completionTime);
+        std::cout << "============================\n";
+
+        auto pk = probabilityDistribution();
+        std::cout << "\nРаспределение числа активных пользователей P(k):\n";
+        std::cout << " k |   P(k)   |   ±95%   | Гистограмма\n";
+        std::cout << "---|----------|----------|------------\n";
+        for (size_t k = 0; k < pk.size(); ++k) {
+            std::cout << std::setw(2) << k << " | "
+                      << std::fixed << std::setprecision(4) << pk[k].mean << " | "
+                      << std::setprecision(4) << pk[k].halfWidth << " | ";
+            int bars = static_cast<int>(pk[k].mean * 50);
+            for (int i = 0; i < bars; ++i) std::cout << "█";
+            std::cout << "\n";
+        }
+        std::cout << "============================\n";
+    }
+};
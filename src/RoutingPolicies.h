@@ -0,0 +1,79 @@
+#pragma once
+#include "IRoutingPolicy.h"
+#include "RandomGenerator.h"
+
+#include <memory>
+#include <string>
+#include <stdexcept>
+
+// Случайный узел, равновероятно (ГСЧ диспетчера)
+class RandomRouting final : public IRoutingPolicy {
+public:
+    size_t route(const std::vector<NodeLoad>& nodes, double, const NodeRateFn&, RandomGenerator& rng) override {
+        return static_cast<size_t>(rng.integer(0, static_cast<int>(nodes.size()) - 1));
+    }
+};
+
+// Узлы по кругу
+class RoundRobinRouting final : public IRoutingPolicy {
+    size_t m_next = 0;
+public:
+    size_t route(const std::vector<NodeLoad>& nodes, double, const NodeRateFn&, RandomGenerator&) override {
+        size_t node = m_next;
+        m_next = (m_next + 1) % nodes.size();
+        return node;
+    }
+};
+
+// Join-shortest-queue: меньше всего задач. Среди равных — равновероятно
+// (выбор с резервуаром на ГСЧ диспетчера), иначе меньшие номера перегружены
+class ShortestQueueRouting final : public IRoutingPolicy {
+public:
+    size_t route(const std::vector<NodeLoad>& nodes, double, const NodeRateFn&, RandomGenerator& rng) override {
+        size_t best = 0;
+        int ties = 1;
+        for (size_t j = 1; j < nodes.size(); ++j) {
+            if (nodes[j].tasks < nodes[best].tasks) {
+                best = j;
+                ties = 1;
+            } else if (nodes[j].tasks == nodes[best].tasks && rng.integer(0, ties++) == 0) {
+                best = j;
+            }
+        }
+        return best;
+    }
+};
+
+// Узел, который после прихода задачи будет работать быстрее остальных:
+// максимум μ₀·f(R_j + w). В отличие от JSQ учитывает объём работы задач,
+// а не только их число. Равные максимумы (например, простаивающие узлы)
+// разыгрываются равновероятно, как в JSQ
+class LeastDegradedRouting final : public IRoutingPolicy {
+public:
+    size_t route(const std::vector<NodeLoad>& nodes, double workload, const NodeRateFn& rate,
+                 RandomGenerator& rng) override {
+        size_t best = 0;
+        int ties = 1;
+        double bestRate = rate(0, nodes[0].workload + workload);
+        for (size_t j = 1; j < nodes.size(); ++j) {
+            double r = rate(j, nodes[j].workload + workload);
+            if (r > bestRate) {
+                best = j;
+                bestRate = r;
+                ties = 1;
+            } else if (r == bestRate && rng.integer(0, ties++) == 0) {
+                best = j;
+            }
+        }
+        return best;
+    }
+};
+
+// random | round-robin (rr) | jsq | least-degraded
+inline std::unique_ptr<IRoutingPolicy> makeRoutingPolicy(const std::string& name) {
+    if (name == "random") return std::make_unique<RandomRouting>();
+    if (name == "round-robin" || name == "rr") return std::make_unique<RoundRobinRouting>();
+    if (name == "jsq") return std::make_unique<ShortestQueueRouting>();
+    if (name == "least-degraded") return std::make_unique<LeastDegradedRouting>();
+    throw std::invalid_argument("Unknown routing policy: " + name + " (random, round-robin, jsq, least-degraded)");
+}
@@ -0,0 +1,208 @@
+// === SequentialStopping.h ===
+#pragma once
+#include "IStoppingRule.h"
+#include "Simulator.h"
+#include "Statistics.h"
+
+#include <vector>
+#include <string>
+#include <iostream>
+#include <iomanip>
+#include <cmath>
+#include <cstddef>
+
+// Последовательная остановка по методу пакетных средних.
+//
+// Наблюдения снимаются на тиках мониторинга: приращения timeInState[k]
+// складываются в пакеты. Когда пакетов становится kMaxBatches, соседние
+// пакеты попарно сливаются, и длина пакета удваивается — число пакетов
+// остаётся ограниченным при любой длине прогона.
+//
+// Начальный переходный участок отбрасывается по MSER, применённому к ряду
+// пакетных средних загрузки: точка усечения d минимизирует
+// Σ_{i≥d} (u_i − ū_d)² / (n − d)². Если минимум оказывается во второй
+// половине ряда, прогрев ещё не закончился. Остановка — когда
+// относительная полуширина 95% ДИ загрузки и каждой P(k) ≥ pkThreshold не
+// превышает цели, а лаг-1 автокорреляция пакетов загрузки мала (пакеты
+// можно считать независимыми). Малые P(k) не отслеживаются: для них
+// относительная точность требует неограниченно длинного прогона.
+class SequentialStopping : public IStoppingRule {
+public:
+    struct Estimate {
+        std::string name;
+        Stats::MeanCI ci;
+    };
+
+    SequentialStopping(int users, double relPrecision, double pkThreshold = 0.01)
+        : m_users(users),
+          m_target(relPrecision),
+          m_pkThreshold(pkThreshold),
+          m_lastTimeInState(users + 1, 0.0),
+          m_current(users + 1, 0.0) {}
+
+    bool shouldStop(const SimulationStats& stats, double time) override {
+        for (size_t k = 0; k < m_current.size(); ++k) {
+            m_current[k] += stats.timeInState[k] - m_lastTimeInState[k];
+            m_lastTimeInState[k] = stats.timeInState[k];
+        }
+        m_currentDuration += time - m_lastTime;
+        m_lastTime = time;
+        if (++m_currentTicks < m_batchTicks) return false;
+
+        m_batches.push_back({m_currentDuration, m_current});
+        std::fill(m_current.begin(), m_current.end(), 0.0);
+        m_currentDuration = 0.0;
+        m_currentTicks = 0;
+
+        if (m_batches.size() == kMaxBatches) mergeBatches();
+        if (m_batches.size() < kMinBatches) return false;
+
+        m_converged = evaluate();
+        return m_converged;
+    }
+
+    bool converged() const { return m_converged; }
+    double truncationTime() const { return m_truncationTime; }
+    size_t batchCount() const { return m_usedBatches; }
+    double batchLength() const { return m_batchLength; }
+    const std::vector<Estimate>& estimates() const { return m_estimates; }
+
+    void printSummary(double stopTime) const {
+        std::cout << "\n=== Последовательная остановка (пакетные средние, 95% ДИ) ===\n";
+        std::cout << "Цель (отн. полуширина): " << std::fixed << std::setprecision(4)
+                  << m_target << "\n";
+        std::cout << "Статус:                 "
+                  << (m_converged ? "точность достигнута" : "точность НЕ достигнута до --time") << "\n";
+        std::cout << "Остановка:              " << std::setprecision(2) << stopTime << " сек\n";
+        std::cout << "Точка усечения (MSER):  " << m_truncationTime << " сек\n";
+        std::cout << "Пакеты:                 " << m_usedBatches << " × "
+                  << m_batchLength << " сек\n";
+        std::cout << "Метрика   |  Среднее  |   ±95%   | Отн.\n";
+        std::cout << "----------|-----------|----------|--------\n";
+        for (const auto& e : m_estimates) {
+            std::cout << std::left << std::setw(9) << e.name << std::right << " | "
+                      << std::setprecision(6) << e.ci.mean << " | "
+                      << e.ci.halfWidth << " | "
+                      << std::setprecision(4) << e.ci.relativeHalfWidth() << "\n";
+        }
+        std::cout << "============================\n";
+    }
+
+private:
+    static constexpr size_t kMaxBatches = 64;
+    static constexpr size_t kMinBatches = kMaxBatches / 2;
+    static constexpr double kMaxLag1 = 0.2;
+
+    struct Batch {
+        double duration;
+        std::vector<double> timeInState;  // время в состоянии k за пакет
+    };
+
+    int m_users;
+    double m_target;
+    double m_pkThreshold;
+
+    std::vector<double> m_lastTimeInState;
+    double m_lastTime = 0.0;
+
+    std::vector<double> m_current;
+    double m_currentDuration = 0.0;
+    int m_currentTicks = 0;
+    int m_batchTicks = 1;           // длина пакета в тиках мониторинга
+    std::vector<Batch> m_batches;
+
+    bool m_converged = false;
+    double m_truncationTime = 0.0;
+    size_t m_usedBatches = 0;
+    double m_batchLength = 0.0;
+    std::vector<Estimate> m_estimates;
+
+    void mergeBatches() {
+        std::vector<Batch> merged;
+        merged.reserve(kMaxBatches);
+        for (size_t i = 0; i + 1 < m_batches.size(); i += 2) {
+            Batch b = m_batches[i];
+            b.duration += m_batches[i + 1].duration;
+            for (size_t k = 0; k < b.timeInState.size(); ++k) {
+                b.timeInState[k] += m_batches[i + 1].timeInState[k];
+            }
+            merged.push_back(std::move(b));
+        }
+        m_batches = std::move(merged);
+        m_batchTicks *= 2;
+    }
+
+    double batchUtilization(const Batch& b) const {
+        double busy = 0.0;
+        for (size_t k = 1; k < b.timeInState.size(); ++k) busy += k * b.timeInState[k];
+        return busy / (b.duration * m_users);
+    }
+
+    // Точка усечения MSER по ряду y; npos — если прогрев не закончился
+    static size_t mserTruncation(const std::vector<double>& y) {
+        const size_t n = y.size();
+        std::vector<double> suffixSum(n + 1, 0.0), suffixSq(n + 1, 0.0);
+        for (size_t i = n; i-- > 0;) {
+            suffixSum[i] = suffixSum[i + 1] + y[i];
+            suffixSq[i] = suffixSq[i + 1] + y[i] * y[i];
+        }
+        size_t best = 0;
+        double bestValue = INFINITY;
+        for (size_t d = 0; d + 5 <= n; ++d) {
+            double m = static_cast<double>(n - d);
+            double ss = suffixSq[d] - suffixSum[d] * suffixSum[d] / m;
+            double value = std::max(0.0, ss) / (m * m);
+            if (value < bestValue) {
+                bestValue = value;
+                best = d;
+            }
+        }
+        return best <= n / 2 ? best : static_cast<size_t>(-1);
+    }
+
+    static double lag1Autocorrelation(const std::vector<double>& y) {
+        if (y.size() < 3) return 0.0;
+        double mean = 0.0;
+        for (double v : y) mean += v;
+        mean /= static_cast<double>(y.size());
+        double num = 0.0, den = 0.0;
+        for (size_t i = 0; i < y.size(); ++i) {
+            den += (y[i] - mean) * (y[i] - mean);
+            if (i + 1 < y.size()) num += (y[i] - mean) * (y[i + 1] - mean);
+        }
+        return den > 0.0 ? num / den : 0.0;
+    }
+
+    bool evaluate() {
+        std::vector<double> utilization;
+        utilization.reserve(m_batches.size());
+        for (const auto& b : m_batches) utilization.push_back(batchUtilization(b));
+
+        size_t d = mserTruncation(utilization);
+        if (d == static_cast<size_t>(-1)) return false;
+
+        m_truncationTime = 0.0;
+        for (size_t i = 0; i < d; ++i) m_truncationTime += m_batches[i].duration;
+        m_usedBatches = m_batches.size() - d;
+        m_batchLength = m_batches.back().duration;
+
+        std::vector<double> kept(utilization.begin() + d, utilization.end());
+        m_estimates.clear();
+        m_estimates.push_back({"rho", Stats::meanCI(kept)});
+        bool precise = m_estimates.back().ci.relativeHalfWidth() <= m_target
+                    && std::abs(lag1Autocorrelation(kept)) <= kMaxLag1;
+
+        for (size_t k = 0; k < m_lastTimeInState.size(); ++k) {
+            std::vector<double> pk;
+            pk.reserve(m_usedBatches);
+            for (size_t i = d; i < m_batches.size(); ++i) {
+                pk.push_back(m_batches[i].timeInState[k] / m_batches[i].duration);
+            }
+            auto ci = Stats::meanCI(pk);
+            if (ci.mean < m_pkThreshold) continue;
+            m_estimates.push_back({"P(" + std::to_string(k) + ")", ci});
+            precise = precise && ci.relativeHalfWidth() <= m_target;
+        }
+        return precise;
+    }
+};
@@ -4,68 +4,189 @@
 #include <stdexcept>
 #include <cmath>
 #include <iostream>
+#include <fstream>
+#include <cstdio>
+#include <numeric>
 
-Simulator::Simulator(
+template <class W, class P, class S, class D>
+BasicSimulator<W, P, S, D>::BasicSimulator(
     int maxUsers,
     double baseServiceRate,
-    std::unique_ptr<Distribution> workloadDist,
-    std::unique_ptr<Distribution> passiveTimeDist,
-    std::unique_ptr<Distribution> serviceTimeDist,
-    std::function<double(double)> degradationFn
+    std::unique_ptr<W> workloadDist,
+    std::unique_ptr<P> passiveTimeDist,
+    std::unique_ptr<S> serviceTimeDist,
+    D degradationFn,
+    RandomGenerator rng
 ) : m_users(maxUsers),
     m_currentTime(0.0),
     m_statUpdateTime(0.0),
     m_baseServiceRate(baseServiceRate),
     m_currentEffectiveRate(baseServiceRate),
     m_workloadDist(std::move(workloadDist)),
-    m_serviceTime(std::move(serviceTimeDist)),
     m_passiveTimeDist(std::move(passiveTimeDist)),
-    m_degradationFn(degradationFn),
-    m_userStates(maxUsers, false),
-    m_lastEventTime(maxUsers, 0.0),
-    m_Workload(maxUsers, 0.0),
-    m_remainingTime(maxUsers, 0.0),
-    m_eventVersion(maxUsers, 0),
-    m_stats(maxUsers),
-    m_eventQueue()
+    m_serviceTime(std::move(serviceTimeDist)),
+    m_degradationFn(std::move(degradationFn)),
+    m_rng(std::move(rng)),
+    m_stats(maxUsers, false)
 {
-    if (!m_workloadDist || !m_passiveTimeDist)
+    if (!m_workloadDist || !m_passiveTimeDist || !m_serviceTime)
         throw std::invalid_argument("Distributions cannot be null");
     if (m_baseServiceRate <= 0.0)
         throw std::invalid_argument("Base service rate must be positive");
 }
 
-void Simulator::initialize() {
+// Память под пользователей выделяется здесь, а не в конструкторе: объём
+// зависит от режима, заданного после создания симулятора
+template <class W, class P, class S, class D>
+void BasicSimulator<W, P, S, D>::allocateUserState() {
+    const size_t n = static_cast<size_t>(m_users);
+    const bool lumped = m_engineMode == EngineMode::Lumped;
+    if (!lumped || m_perUserStats) m_userStates.assign(n, false);
+    if (m_perUserStats) m_lastEventTime.assign(n, m_currentTime);
+    if (!lumped) {
+        m_userTask.assign(n, UserTask{0.0, 0.0});
+        m_eventVersion.assign(n, 0);
+        m_eventQueue.reserve(m_users);
+        if (m_engineMode == EngineMode::VirtualTime) m_virtualFinish.reserve(m_users);
+    }
+    if (m_commonRandom) {
+        RandomGenerator base = m_rng;
+        base.setInverseTransform(true);
+        m_userRng.clear();
+        m_userRng.reserve(3 * n);
+        for (size_t i = 0; i < 3 * n; ++i) m_userRng.push_back(base.substream(i));
+    }
+    m_stats.setPerUser(m_perUserStats);
+}
+
+template <class W, class P, class S, class D>
+void BasicSimulator<W, P, S, D>::checkLumpedDistributions() {
+    auto* passive = dynamic_cast<const ExponentialDist*>(m_passiveTimeDist.get());
+    auto* service = dynamic_cast<const ExponentialDist*>(m_serviceTime.get());
+    if (!passive || !service)
+        throw std::invalid_argument("Lumped engine requires exponential passive and service time distributions");
+    m_passiveRate = passive->rate();
+}
+
+template <class W, class P, class S, class D>
+void BasicSimulator<W, P, S, D>::initialize() {
+    if (m_engineMode == EngineMode::Lumped) {
+        if (m_partition) throw std::invalid_argument("Cluster nodes do not support the lumped engine");
+        if (m_commonRandom) throw std::invalid_argument("Common random numbers need per-user events (rescale or vtime engine)");
+        checkLumpedDistributions();
+    }
+    allocateUserState();
+    m_nextMonitorTime = m_currentTime + m_monitorInterval;
+    resetWindow(m_currentTime);
+    m_initialized = true;
+    
+    if (m_engineMode == EngineMode::Lumped) {
+        m_lumpedTasks.clear();
+        m_idleUsers.clear();
+        if (m_perUserStats) {
+            m_idleUsers.resize(m_users);
+            std::iota(m_idleUsers.begin(), m_idleUsers.end(), 0);
+        }
+        scheduleLumpedEvent();
+        return;
+    }
+    if (m_partition) return;
+    
     for (int userId = 0; userId < m_users; ++userId) {
-        double nextActivation = m_currentTime + m_passiveTimeDist->sample();
+        double nextActivation = m_currentTime + drawPassive(userId);
         m_eventVersion[userId]++;
         m_eventQueue.push(
             nextActivation,
             EventType::ACTIVATION,
             userId,
-            m_eventVersion[userId],
-            [this, userId]() { handleActivation(userId); }
+            m_eventVersion[userId]
         );
-        m_lastEventTime[userId] = m_currentTime;
     }
-    scheduleMonitoring(m_currentTime + 1.0);
 }
 
-void Simulator::scheduleMonitoring(double nextTime) {
-    if (nextTime <= m_currentTime) return;
-    m_eventQueue.push(
-        nextTime,
-        EventType::MONITORING,
-        -1,
-        0,
-        [this, nextTime]() {
-            handleMonitoring();
-            scheduleMonitoring(nextTime + 1.0);
+template <class W, class P, class S, class D>
+void BasicSimulator<W, P, S, D>::setMonitorInterval(double interval) {
+    if (interval <= 0.0) throw std::invalid_argument("Monitor interval must be positive");
+    m_monitorInterval = interval;
+    if (!m_initialized) m_nextMonitorTime = m_currentTime + interval;
+}
+
+template <class W, class P, class S, class D>
+void BasicSimulator<W, P, S, D>::setAggregationWindow(double length) {
+    if (length < 0.0) throw std::invalid_argument("Aggregation window must be non-negative");
+    m_windowLength = length;
+    resetWindow(m_currentTime);
+}
+
+// Тики мониторинга строго до time: события в момент тика уже обработаны,
+// как прежде при упорядочивании MONITORING после событий пользователей
+template <class W, class P, class S, class D>
+void BasicSimulator<W, P, S, D>::monitorUntil(double time) {
+    while (m_nextMonitorTime < time && !m_stopRequested) {
+        Profiler::Scope scope(m_profiler, ProfileSection::Monitoring);
+        m_currentTime = m_nextMonitorTime;
+        handleMonitoring();
+        if (m_stoppingRule) {
+            updateGlobalStatistics(m_currentTime);
+            m_stopRequested = m_stoppingRule->shouldStop(m_stats, m_currentTime);
         }
-    );
+        m_nextMonitorTime += m_monitorInterval;
+    }
+}
+
+template <class W, class P, class S, class D>
+void BasicSimulator<W, P, S, D>::resetWindow(double start) {
+    m_windowStart = start;
+    m_windowUpdateTime = start;
+    m_windowActiveIntegral = 0.0;
+    m_windowRateIntegral = 0.0;
+    m_windowMinActive = m_windowMaxActive = m_activeCount;
+    m_windowMinRate = m_windowMaxRate = m_currentEffectiveRate;
 }
 
-void Simulator::handleActivation(int userId) {
+// Интегрирует состояние до time, закрывая и рассылая завершённые окна.
+// Неполное окно в конце прогона не выдаётся — его продолжит следующий runUntil
+template <class W, class P, class S, class D>
+void BasicSimulator<W, P, S, D>::advanceWindow(double time) {
+    if (m_windowLength <= 0.0) return;
+    
+    while (m_windowStart + m_windowLength <= time) {
+        double end = m_windowStart + m_windowLength;
+        double dt = end - m_windowUpdateTime;
+        m_windowActiveIntegral += m_activeCount * dt;
+        m_windowRateIntegral += m_currentEffectiveRate * dt;
+        
+        WindowSummary window{
+            m_windowStart, end,
+            m_windowActiveIntegral / m_windowLength, m_windowMinActive, m_windowMaxActive,
+            m_windowRateIntegral / m_windowLength, m_windowMinRate, m_windowMaxRate
+        };
+        {
+            Profiler::Scope scope(m_profiler, ProfileSection::Listener);
+            for (auto* listener : m_listeners) listener->onWindow(window);
+        }
+        resetWindow(end);
+    }
+    
+    double dt = time - m_windowUpdateTime;
+    if (dt > 0.0) {
+        m_windowActiveIntegral += m_activeCount * dt;
+        m_windowRateIntegral += m_currentEffectiveRate * dt;
+        m_windowUpdateTime = time;
+    }
+}
+
+template <class W, class P, class S, class D>
+void BasicSimulator<W, P, S, D>::observeWindowState() {
+    if (m_windowLength <= 0.0) return;
+    m_windowMinActive = std::min(m_windowMinActive, m_activeCount);
+    m_windowMaxActive = std::max(m_windowMaxActive, m_activeCount);
+    m_windowMinRate = std::min(m_windowMinRate, m_currentEffectiveRate);
+    m_windowMaxRate = std::max(m_windowMaxRate, m_currentEffectiveRate);
+}
+
+template <class W, class P, class S, class D>
+void BasicSimulator<W, P, S, D>::handleActivation(int userId) {
     if (userId < 0 || userId >= m_users) {
         std::cerr << "[ERROR] Invalid userId=" << userId << " in handleActivation\n";
         return;
@@ -73,41 +194,61 @@ void Simulator::handleActivation(int userId) {
     
     updateGlobalStatistics(m_currentTime);
     updateStatistics(userId, m_currentTime);
+    advanceVirtualTime();
     
-    double oldTotalWorkload = getTotalWorkload();
-    double oldRate = computeEffectiveRate(oldTotalWorkload);
+    double oldRate = computeEffectiveRate(getTotalWorkload());
     
-    double workload = m_workloadDist->sample();
-    m_Workload[userId] = workload;
+    double workload = m_userTask[userId].workload;  // узлу кластера объём задан диспетчером
+    if (!m_partition) {
+        workload = drawWorkload(userId);
+        m_userTask[userId].workload = workload;
+    }
     
-    double newTotalWorkload = oldTotalWorkload + workload;
-    double newRate = computeEffectiveRate(newTotalWorkload);
+    addToTotalWorkload(workload);
+    double newRate = computeEffectiveRate(getTotalWorkload());
     
-    rescaleRemainingTimes(oldRate, newRate, -1);
+    if (m_engineMode == EngineMode::Rescale) {
+        deferRescale(oldRate, newRate);
+        m_batchActivated.emplace_back(userId, m_batchSteps.size());
+    }
     
     m_userStates[userId] = true;
+    m_userTask[userId].activationTime = m_currentTime;
+    ++m_activeCount;
     
-    double initialTime = m_serviceTime->sample(newRate);
-    
-    m_remainingTime[userId] = initialTime;
+    double initialTime = m_serviceTime->sample(drawStream(userId, RngSource::Service), newRate);
+    m_profiler.countRng(RngSource::Service);
     
     m_eventVersion[userId]++;
-    m_eventQueue.push(
-        m_currentTime + initialTime,
-        EventType::DEACTIVATION,
-        userId,
-        m_eventVersion[userId],
-        [this, userId]() { handleDeactivation(userId); }
-    );
+    if (m_engineMode == EngineMode::VirtualTime) {
+        // Объём обслуживания в единицах виртуального времени: время при текущей скорости × скорость
+        m_virtualFinish.push(
+            m_virtualTime + initialTime * newRate,
+            EventType::DEACTIVATION,
+            userId,
+            m_eventVersion[userId]
+        );
+    } else {
+        m_eventQueue.push(
+            m_currentTime + initialTime,
+            EventType::DEACTIVATION,
+            userId,
+            m_eventVersion[userId]
+        );
+    }
     
-    int activeCount = std::count(m_userStates.begin(), m_userStates.end(), true);
-    m_stats.maxConcurrentUsers = std::max(m_stats.maxConcurrentUsers, activeCount);
+    m_stats.maxConcurrentUsers = std::max(m_stats.maxConcurrentUsers, m_activeCount);
     
     m_currentEffectiveRate = newRate;
     m_stats.recordDegradation(newRate / m_baseServiceRate);
+    
+    if (m_engineMode == EngineMode::VirtualTime) {
+        m_completionPending = true;
+    }
 }
 
-void Simulator::handleDeactivation(int userId) {
+template <class W, class P, class S, class D>
+void BasicSimulator<W, P, S, D>::handleDeactivation(int userId) {
     if (userId < 0 || userId >= m_users) {
         std::cerr << "[ERROR] Invalid userId=" << userId << " in handleDeactivation\n";
         return;
@@ -115,108 +256,423 @@ void Simulator::handleDeactivation(int userId) {
     
     updateGlobalStatistics(m_currentTime);
     updateStatistics(userId, m_currentTime);
+    advanceVirtualTime();
     
-    double oldTotalWorkload = getTotalWorkload();
-    double oldRate = computeEffectiveRate(oldTotalWorkload);
+    double oldRate = computeEffectiveRate(getTotalWorkload());
     
-    double freedWorkload = m_Workload[userId];
-    m_Workload[userId] = 0.0;
-    m_remainingTime[userId] = 0.0;
+    double freedWorkload = m_userTask[userId].workload;
+    m_userTask[userId].workload = 0.0;
     
-    double newTotalWorkload = oldTotalWorkload - freedWorkload;
-    double newRate = computeEffectiveRate(newTotalWorkload);
+    if (m_activeCount == 1) {
+        // Узел опустел: обнуляем сумму точно, без накопленного остатка
+        m_totalWorkload = 0.0;
+        m_workloadCompensation = 0.0;
+    } else {
+        addToTotalWorkload(-freedWorkload);
+    }
+    double newRate = computeEffectiveRate(getTotalWorkload());
     
-    rescaleRemainingTimes(oldRate, newRate, userId);
+    if (m_engineMode == EngineMode::VirtualTime) {
+        m_virtualFinish.cancel(userId);
+        if (m_completionUser == userId) m_completionUser = -1;
+    } else {
+        rescaleRemainingTimes(oldRate, newRate, userId);
+    }
     
     m_userStates[userId] = false;
+    --m_activeCount;
     
-    m_stats.taskCount[userId]++;
-    m_stats.totalWorkCompleted[userId] += freedWorkload;
-    m_stats.totalWorkProcessed += freedWorkload;
-    
-    double completionTime = freedWorkload / oldRate;
-    int bucket = static_cast<int>(completionTime * 10);
-    m_stats.completionTimeHistogram[bucket] += 1.0;
+    m_stats.recordCompletion(userId, freedWorkload, m_currentTime - m_userTask[userId].activationTime);
     
-    double nextPassive = m_passiveTimeDist->sample();
-    m_eventVersion[userId]++;
-    m_eventQueue.push(
-        m_currentTime + nextPassive,
-        EventType::ACTIVATION,
-        userId,
-        m_eventVersion[userId],
-        [this, userId]() { handleActivation(userId); }
-    );
+    if (m_partition) {
+        // Простой узла кластера планирует диспетчер
+        m_departures.push_back({m_currentTime, userId});
+    } else {
+        double nextPassive = drawPassive(userId);
+        m_eventVersion[userId]++;
+        m_eventQueue.push(
+            m_currentTime + nextPassive,
+            EventType::ACTIVATION,
+            userId,
+            m_eventVersion[userId]
+        );
+    }
     
     m_currentEffectiveRate = newRate;
+    
+    if (m_engineMode == EngineMode::VirtualTime) {
+        m_completionPending = true;
+    }
+}
+
+// Следующее событие агрегированного режима: время до него — Exp(n_idle·λ + k·μ(R)),
+// тип выбирается сразу, чтобы событие целиком лежало в очереди (и в контрольной точке)
+template <class W, class P, class S, class D>
+void BasicSimulator<W, P, S, D>::scheduleLumpedEvent() {
+    double activationRate = (m_users - m_activeCount) * m_passiveRate;
+    double completionRate = m_activeCount * m_currentEffectiveRate;
+    double totalRate = activationRate + completionRate;
+    if (!(totalRate > 0.0)) {
+        m_eventQueue.cancel(-1);
+        return;
+    }
+    double delay = m_rng.standardExponential() / totalRate;
+    EventType type = m_rng.uniform01() * totalRate < activationRate
+        ? EventType::ACTIVATION : EventType::DEACTIVATION;
+    m_profiler.countRng(RngSource::Event, 2);
+    m_eventQueue.push(m_currentTime + delay, type, -1, 0);
+}
+
+template <class W, class P, class S, class D>
+void BasicSimulator<W, P, S, D>::handleLumpedActivation() {
+    updateGlobalStatistics(m_currentTime);
+    
+    // Активируется равновероятный из простаивающих — выбирать его нужно только для учёта
+    int userId = -1;
+    if (m_perUserStats) {
+        size_t pick = std::min(static_cast<size_t>(m_rng.uniform01() * m_idleUsers.size()), m_idleUsers.size() - 1);
+        userId = m_idleUsers[pick];
+        m_idleUsers[pick] = m_idleUsers.back();
+        m_idleUsers.pop_back();
+        updateStatistics(userId, m_currentTime);
+        m_userStates[userId] = true;
+        m_profiler.countRng(RngSource::Passive);
+    }
+    
+    double workload = m_workloadDist->next(m_rng);
+    m_profiler.countRng(RngSource::Workload);
+    addToTotalWorkload(workload);
+    m_lumpedTasks.push_back({workload, m_currentTime, userId});
+    ++m_activeCount;
+    
+    m_currentEffectiveRate = computeEffectiveRate(getTotalWorkload());
+    m_stats.maxConcurrentUsers = std::max(m_stats.maxConcurrentUsers, m_activeCount);
+    m_stats.recordDegradation(m_currentEffectiveRate / m_baseServiceRate);
+    
+    scheduleLumpedEvent();
+}
+
+template <class W, class P, class S, class D>
+void BasicSimulator<W, P, S, D>::handleLumpedCompletion() {
+    updateGlobalStatistics(m_currentTime);
+    
+    // У всех активных одинаковая интенсивность завершения μ(R): завершается равновероятная задача
+    size_t pick = std::min(static_cast<size_t>(m_rng.uniform01() * m_lumpedTasks.size()), m_lumpedTasks.size() - 1);
+    LumpedTask task = m_lumpedTasks[pick];
+    m_lumpedTasks[pick] = m_lumpedTasks.back();
+    m_lumpedTasks.pop_back();
+    m_profiler.countRng(RngSource::Service);
+    
+    if (m_activeCount == 1) {
+        m_totalWorkload = 0.0;
+        m_workloadCompensation = 0.0;
+    } else {
+        addToTotalWorkload(-task.workload);
+    }
+    --m_activeCount;
+    
+    if (task.userId >= 0) {
+        updateStatistics(task.userId, m_currentTime);
+        m_userStates[task.userId] = false;
+        m_idleUsers.push_back(task.userId);
+    }
+    m_stats.recordCompletion(task.userId, task.workload, m_currentTime - task.activationTime);
+    
+    m_currentEffectiveRate = computeEffectiveRate(getTotalWorkload());
+    
+    scheduleLumpedEvent();
 }
 
-void Simulator::runUntil(double endTime) {
+template <class W, class P, class S, class D>
+void BasicSimulator<W, P, S, D>::runUntil(double endTime) {
     if (endTime <= 0.0)
         throw std::invalid_argument("Simulation time must be > 0");
+    if (endTime < m_currentTime)
+        throw std::invalid_argument("runUntil: endTime is before the current time");
     
-    m_statUpdateTime = 0.0;
-    m_currentTime = 0.0;
-    initialize();
+    m_stopRequested = false;
+    Profiler::Scope runScope(m_profiler, ProfileSection::Run);
+    if (!m_initialized) initialize();
     
-    while (!m_eventQueue.empty() && m_currentTime < endTime) {
-        Event event = m_eventQueue.pop();
+    while (!m_stopRequested) {
+        if (!continuesBatch()) flushBatch();
+        double horizon = m_eventQueue.empty() ? endTime : std::min(m_eventQueue.peek().time, endTime);
+        monitorUntil(horizon);
+        if (m_stopRequested || m_eventQueue.empty() || m_eventQueue.peek().time >= endTime) break;
+        
+        const Event event = m_eventQueue.pop();
         
         if (event.userId >= 0 && event.userId < m_users) {
-            if (event.eventVersion < m_eventVersion[event.userId]) {
+            if (event.eventVersion != m_eventVersion[event.userId]) {
+                m_profiler.countStale();
                 continue;
             }
         }
         
+        advanceWindow(event.time);
         m_currentTime = event.time;
-        event.handler();
+        switch (event.type()) {
+            case EventType::ACTIVATION: {
+                Profiler::Scope scope(m_profiler, ProfileSection::Activation);
+                if (m_engineMode == EngineMode::Lumped) handleLumpedActivation();
+                else handleActivation(event.userId);
+                break;
+            }
+            case EventType::DEACTIVATION: {
+                Profiler::Scope scope(m_profiler, ProfileSection::Deactivation);
+                if (m_engineMode == EngineMode::Lumped) handleLumpedCompletion();
+                else handleDeactivation(event.userId);
+                break;
+            }
+        }
+        if (m_partition) m_stateLog.push_back({m_currentTime, m_activeCount, getTotalWorkload()});
+        m_profiler.observeQueue(m_eventQueue.size() + m_virtualFinish.size());
+        observeWindowState();
         m_stats.totalEventsProcessed++;
+#ifdef SIMULATOR_CHECK_INVARIANTS
+        checkInvariants();
+#endif
+        if (m_activeCount < m_watchLow || m_activeCount >= m_watchHigh) m_stopRequested = true;
     }
     
-    for (int userId = 0; userId < m_users; ++userId) {
-        updateStatistics(userId, endTime);
+    flushBatch();
+    double stopTime = m_stopRequested ? m_currentTime : endTime;
+    advanceWindow(stopTime);
+    if (m_perUserStats) {
+        for (int userId = 0; userId < m_users; ++userId) {
+            updateStatistics(userId, stopTime);
+        }
+    }
+    updateGlobalStatistics(stopTime);
+    m_stats.totalSimulationTime = stopTime;
+    m_currentTime = stopTime;
+}
+
+template <class W, class P, class S, class D>
+std::unique_ptr<BasicSimulator<W, P, S, D>> BasicSimulator<W, P, S, D>::clone(RandomGenerator rng) {
+    if (m_commonRandom) throw std::logic_error("Cloning does not support common random numbers");
+    // Гистограмма времён отклика (~61 КБ) на время копирования подменяется
+    // пустой, а копия её не пополняет
+    LatencyQuantiles completionTime(m_stats.completionTime.method());
+    std::swap(completionTime, m_stats.completionTime);
+    std::unique_ptr<BasicSimulator> copy(new BasicSimulator(*this));
+    std::swap(completionTime, m_stats.completionTime);
+    copy->m_stats.recordLatency = false;
+    copy->m_rng = std::move(rng);
+    copy->m_listeners.clear();
+    copy->m_stoppingRule = nullptr;
+    // Копия обычно живёт несколько событий: пакет в 256 величин на каждую
+    // был бы основной её стоимостью
+    copy->m_workloadDist->resetBuffer(1);
+    copy->m_passiveTimeDist->resetBuffer(1);
+    copy->m_serviceTime->resetBuffer(1);
+    // Агрегированный поток событий без памяти: следующее событие копии
+    // разыгрывается заново, иначе все копии сделали бы один и тот же шаг.
+    // В остальных режимах копируются уже выбранные моменты событий
+    if (m_engineMode == EngineMode::Lumped && m_initialized) copy->scheduleLumpedEvent();
+    return copy;
+}
+
+namespace {
+constexpr char kCheckpointMagic[8] = {'S', 'R', 'W', 'C', 'K', 'P', 'T', '6'};
+}
+
+template <class W, class P, class S, class D>
+void BasicSimulator<W, P, S, D>::saveCheckpoint(const std::string& path) const {
+    // Пишем во временный файл и переименовываем: прерванная запись
+    // не портит предыдущую контрольную точку
+    if (m_commonRandom) throw std::logic_error("Checkpoints do not support common random numbers");
+    const std::string tmpPath = path + ".tmp";
+    {
+        std::ofstream out(tmpPath, std::ios::binary);
+        if (!out) throw std::runtime_error("Cannot open checkpoint file: " + tmpPath);
+        
+        out.write(kCheckpointMagic, sizeof(kCheckpointMagic));
+        BinaryIO::write<int32_t>(out, m_users);
+        BinaryIO::write<int32_t>(out, static_cast<int32_t>(m_engineMode));
+        BinaryIO::write(out, m_baseServiceRate);
+        BinaryIO::writeString(out, m_workloadDist->name());
+        BinaryIO::writeString(out, m_passiveTimeDist->name());
+        BinaryIO::writeString(out, m_serviceTime->name());
+        BinaryIO::writeString(out, m_degradationName);
+        BinaryIO::write<int32_t>(out, static_cast<int32_t>(m_stats.completionTime.method()));
+        BinaryIO::write<uint8_t>(out, m_perUserStats ? 1 : 0);
+        
+        BinaryIO::write<uint8_t>(out, m_initialized ? 1 : 0);
+        BinaryIO::write(out, m_currentTime);
+        BinaryIO::write(out, m_statUpdateTime);
+        BinaryIO::write(out, m_currentEffectiveRate);
+        BinaryIO::writeBools(out, m_userStates);
+        BinaryIO::writeVector(out, m_userTask);
+        BinaryIO::writeVector(out, m_eventVersion);
+        BinaryIO::writeVector(out, m_lastEventTime);
+        BinaryIO::write(out, m_activeCount);
+        BinaryIO::write(out, m_totalWorkload);
+        BinaryIO::write(out, m_workloadCompensation);
+        BinaryIO::write(out, m_virtualTime);
+        BinaryIO::write(out, m_virtualUpdateTime);
+        BinaryIO::write(out, m_completionUser);
+        BinaryIO::write(out, m_nextMonitorTime);
+        BinaryIO::write(out, m_windowStart);
+        BinaryIO::write(out, m_windowUpdateTime);
+        BinaryIO::write(out, m_windowActiveIntegral);
+        BinaryIO::write(out, m_windowRateIntegral);
+        BinaryIO::write(out, m_windowMinActive);
+        BinaryIO::write(out, m_windowMaxActive);
+        BinaryIO::write(out, m_windowMinRate);
+        BinaryIO::write(out, m_windowMaxRate);
+        // Поля задач пишутся по отдельности: хвостовое выравнивание записи
+        // не инициализировано, и побайтовая запись делала бы файлы разными
+        BinaryIO::write<uint64_t>(out, m_lumpedTasks.size());
+        for (const auto& task : m_lumpedTasks) {
+            BinaryIO::write(out, task.workload);
+            BinaryIO::write(out, task.activationTime);
+            BinaryIO::write<int32_t>(out, task.userId);
+        }
+        BinaryIO::writeVector(out, m_idleUsers);
+        
+        m_stats.save(out);
+        m_eventQueue.save(out);
+        m_virtualFinish.save(out);
+        BinaryIO::writeString(out, m_rng.getState());
+        m_workloadDist->saveBuffer(out);
+        m_passiveTimeDist->saveBuffer(out);
+        m_serviceTime->saveBuffer(out);
+        
+        if (!out) throw std::runtime_error("Failed to write checkpoint: " + tmpPath);
+    }
+    if (std::rename(tmpPath.c_str(), path.c_str()) != 0)
+        throw std::runtime_error("Cannot replace checkpoint file: " + path);
+}
+
+template <class W, class P, class S, class D>
+void BasicSimulator<W, P, S, D>::loadCheckpoint(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) throw std::runtime_error("Cannot open checkpoint file: " + path);
+    
+    char magic[sizeof(kCheckpointMagic)];
+    if (!in.read(magic, sizeof(magic)) || !std::equal(magic, magic + sizeof(magic), kCheckpointMagic))
+        throw std::runtime_error("Not a simulator checkpoint: " + path);
+    
+    auto expect = [&](bool ok, const std::string& what) {
+        if (!ok) throw std::runtime_error("Checkpoint does not match the simulator: " + what);
+    };
+    expect(BinaryIO::read<int32_t>(in) == m_users, "users");
+    expect(BinaryIO::read<int32_t>(in) == static_cast<int32_t>(m_engineMode), "engine");
+    expect(BinaryIO::read<double>(in) == m_baseServiceRate, "base rate");
+    expect(BinaryIO::readString(in) == m_workloadDist->name(), "workload distribution");
+    expect(BinaryIO::readString(in) == m_passiveTimeDist->name(), "passive distribution");
+    expect(BinaryIO::readString(in) == m_serviceTime->name(), "service time distribution");
+    expect(BinaryIO::readString(in) == m_degradationName, "degradation function");
+    expect(BinaryIO::read<int32_t>(in) == static_cast<int32_t>(m_stats.completionTime.method()), "quantile method");
+    expect((BinaryIO::read<uint8_t>(in) != 0) == m_perUserStats, "per-user statistics");
+    if (m_engineMode == EngineMode::Lumped) checkLumpedDistributions();
+    
+    m_initialized = BinaryIO::read<uint8_t>(in) != 0;
+    m_currentTime = BinaryIO::read<double>(in);
+    m_statUpdateTime = BinaryIO::read<double>(in);
+    m_currentEffectiveRate = BinaryIO::read<double>(in);
+    m_userStates = BinaryIO::readBools(in);
+    m_userTask = BinaryIO::readVector<UserTask>(in);
+    m_eventVersion = BinaryIO::readVector<uint32_t>(in);
+    m_lastEventTime = BinaryIO::readVector<double>(in);
+    m_activeCount = BinaryIO::read<int>(in);
+    m_totalWorkload = BinaryIO::read<double>(in);
+    m_workloadCompensation = BinaryIO::read<double>(in);
+    m_virtualTime = BinaryIO::read<double>(in);
+    m_virtualUpdateTime = BinaryIO::read<double>(in);
+    m_completionUser = BinaryIO::read<int>(in);
+    m_nextMonitorTime = BinaryIO::read<double>(in);
+    m_windowStart = BinaryIO::read<double>(in);
+    m_windowUpdateTime = BinaryIO::read<double>(in);
+    m_windowActiveIntegral = BinaryIO::read<double>(in);
+    m_windowRateIntegral = BinaryIO::read<double>(in);
+    m_windowMinActive = BinaryIO::read<int>(in);
+    m_windowMaxActive = BinaryIO::read<int>(in);
+    m_windowMinRate = BinaryIO::read<double>(in);
+    m_windowMaxRate = BinaryIO::read<double>(in);
+    m_lumpedTasks.resize(BinaryIO::read<uint64_t>(in));
+    for (auto& task : m_lumpedTasks) {
+        task.workload = BinaryIO::read<double>(in);
+        task.activationTime = BinaryIO::read<double>(in);
+        task.userId = BinaryIO::read<int32_t>(in);
     }
-    updateGlobalStatistics(endTime);
-    m_stats.totalSimulationTime = endTime;
+    m_idleUsers = BinaryIO::readVector<int>(in);
+    
+    m_stats.load(in);
+    m_eventQueue.load(in);
+    m_virtualFinish.load(in);
+    m_rng.setState(BinaryIO::readString(in));
+    m_workloadDist->loadBuffer(in, m_rng);
+    m_passiveTimeDist->loadBuffer(in, m_rng);
+    m_serviceTime->loadBuffer(in, m_rng);
+    
+    // Размеры состояния пользователей зависят от режима (см. allocateUserState)
+    const size_t users = static_cast<size_t>(m_users);
+    const size_t eventUsers = m_engineMode == EngineMode::Lumped ? 0 : users;
+    expect(m_userStates.size() == (eventUsers > 0 || m_perUserStats ? users : 0)
+           && m_userTask.size() == eventUsers
+           && m_eventVersion.size() == eventUsers
+           && m_lastEventTime.size() == (m_perUserStats ? users : 0), "per-user state size");
+}
+
+template <class W, class P, class S, class D>
+size_t BasicSimulator<W, P, S, D>::stateBytes() const {
+    return m_userStates.capacity() / 8
+         + m_userTask.capacity() * sizeof(UserTask)
+         + m_eventVersion.capacity() * sizeof(uint32_t)
+         + m_lastEventTime.capacity() * sizeof(double)
+         + m_lumpedTasks.capacity() * sizeof(LumpedTask)
+         + m_idleUsers.capacity() * sizeof(int)
+         + m_userRng.capacity() * sizeof(RandomGenerator)
+         + m_eventQueue.memoryBytes()
+         + m_virtualFinish.memoryBytes()
+         + m_stats.memoryBytes();
 }
 
-void Simulator::attachListener(ISimulationListener* listener) {
+template <class W, class P, class S, class D>
+void BasicSimulator<W, P, S, D>::attachListener(ISimulationListener* listener) {
     if (listener) {
         m_listeners.push_back(listener);
     }
 }
 
-void Simulator::notifyListeners() {
+template <class W, class P, class S, class D>
+void BasicSimulator<W, P, S, D>::notifyListeners() {
     if (m_listeners.empty()) return;
 
     // Собираем данные в структуру (Simulator знает свои данные, но не знает, куда они пойдут)
     SimulationSnapshot snapshot;
     snapshot.time = m_currentTime;
-    snapshot.activeUsers = std::count(m_userStates.begin(), m_userStates.end(), true);
+    snapshot.activeUsers = m_activeCount;
     snapshot.totalWorkload = getTotalWorkload();
     snapshot.effectiveRate = m_currentEffectiveRate; // или computeEffectiveRate(...)
     snapshot.degradationFactor = snapshot.effectiveRate / m_baseServiceRate;
 
     // Рассылаем всем подписчикам
+    Profiler::Scope scope(m_profiler, ProfileSection::Listener);
     for (auto* listener : m_listeners) {
         listener->onSnapshot(snapshot);
     }
 }
 
-void Simulator::handleMonitoring() {
-    // Вызываем уведомление в момент мониторинга
-    notifyListeners(); 
+template <class W, class P, class S, class D>
+void BasicSimulator<W, P, S, D>::handleMonitoring() {
+    // При агрегации по окнам точечные снимки не рассылаются
+    if (m_windowLength <= 0.0) notifyListeners();
 }
 
 // В деструкторе или методе завершения симуляции:
-void Simulator::finalize() {
+template <class W, class P, class S, class D>
+void BasicSimulator<W, P, S, D>::finalize() {
     for (auto* listener : m_listeners) {
         listener->onSimulationEnd();
     }
 }
 
-void Simulator::updateStatistics(int userId, double currentTime) {
-    if (userId < 0 || userId >= m_users) return;
+template <class W, class P, class S, class D>
+void BasicSimulator<W, P, S, D>::updateStatistics(int userId, double currentTime) {
+    if (userId < 0 || userId >= m_users || !m_perUserStats) return;
     
     double dt = currentTime - m_lastEventTime[userId];
     if (dt <= 0.0) return;
@@ -230,42 +686,243 @@ void Simulator::updateStatistics(int userId, double currentTime) {
     m_lastEventTime[userId] = currentTime;
 }
 
-void Simulator::updateGlobalStatistics(double currentTime) {
+template <class W, class P, class S, class D>
+void BasicSimulator<W, P, S, D>::updateGlobalStatistics(double currentTime) {
     if (currentTime <= m_statUpdateTime) return;
     
-    int activeCount = std::count(m_userStates.begin(), m_userStates.end(), true);
     double dt = currentTime - m_statUpdateTime;
     
-    if (activeCount >= 0 && activeCount <= m_users) {
-        m_stats.timeInState[activeCount] += dt;
+    if (m_activeCount >= 0 && m_activeCount <= m_users) {
+        m_stats.timeInState[m_activeCount] += dt;
+    }
+    if (!m_perUserStats) {
+        // Без учёта по пользователям время копится сразу по всем
+        double busy = m_activeCount * dt;
+        m_stats.nodeBusyTime += busy;
+        m_stats.pooledActiveTime += busy;
+        m_stats.pooledPassiveTime += (m_users - m_activeCount) * dt;
     }
     m_statUpdateTime = currentTime;
 }
 
-double Simulator::getTotalWorkload() const {
-    double total = 0.0;
-    for (int i = 0; i < m_users; ++i) {
-        if (m_userStates[i] && m_Workload[i] > 0.0) {
-            total += m_Workload[i];
+template <class W, class P, class S, class D>
+double BasicSimulator<W, P, S, D>::getTotalWorkload() const {
+    return m_totalWorkload + m_workloadCompensation;
+}
+
+template <class W, class P, class S, class D>
+void BasicSimulator<W, P, S, D>::addToTotalWorkload(double delta) {
+    // Суммирование Ноймайера (Kahan–Babuška): устойчиво и к удалению слагаемых
+    double sum = m_totalWorkload + delta;
+    if (std::abs(m_totalWorkload) >= std::abs(delta)) {
+        m_workloadCompensation += (m_totalWorkload - sum) + delta;
+    } else {
+        m_workloadCompensation += (delta - sum) + m_totalWorkload;
+    }
+    m_totalWorkload = sum;
+}
+
+template <class W, class P, class S, class D>
+void BasicSimulator<W, P, S, D>::checkInvariants() const {
+    int activeCount = 0;
+    double totalWorkload = 0.0;
+    if (m_engineMode == EngineMode::Lumped) {
+        activeCount = static_cast<int>(m_lumpedTasks.size());
+        for (const auto& task : m_lumpedTasks) totalWorkload += task.workload;
+        if (m_perUserStats && m_idleUsers.size() + m_lumpedTasks.size() != static_cast<size_t>(m_users))
+            throw std::logic_error("Invariant violated: idle + active users != " + std::to_string(m_users));
+    } else {
+        for (int i = 0; i < m_users; ++i) {
+            if (!m_userStates[i]) continue;
+            ++activeCount;
+            totalWorkload += m_userTask[i].workload;
         }
     }
-    return total;
+    if (activeCount != m_activeCount) {
+        throw std::logic_error("Invariant violated: active count " + std::to_string(m_activeCount)
+                               + " != recount " + std::to_string(activeCount));
+    }
+    if (std::abs(getTotalWorkload() - totalWorkload) > 1e-9 * std::max(1.0, totalWorkload)) {
+        throw std::logic_error("Invariant violated: total workload " + std::to_string(getTotalWorkload())
+                               + " != recount " + std::to_string(totalWorkload));
+    }
 }
 
-double Simulator::computeEffectiveRate(double totalWorkload) const {
+template <class W, class P, class S, class D>
+double BasicSimulator<W, P, S, D>::computeEffectiveRate(double totalWorkload) const {
     return m_baseServiceRate * m_degradationFn(totalWorkload);
 }
 
-void Simulator::rescaleRemainingTimes(double oldRate, double newRate, int excludingUserId) {
+template <class W, class P, class S, class D>
+void BasicSimulator<W, P, S, D>::setEngineMode(EngineMode mode) {
+    m_engineMode = mode;
+}
+
+// Буфер распределения привязан к одному генератору, поэтому подпотоки
+// пользователей выдают величины по одной через sample
+template <class W, class P, class S, class D>
+double BasicSimulator<W, P, S, D>::drawPassive(int userId) {
+    double value = m_commonRandom ? m_passiveTimeDist->sample(drawStream(userId, RngSource::Passive))
+                                  : m_passiveTimeDist->next(m_rng);
+    m_profiler.countRng(RngSource::Passive);
+    m_drawSum[static_cast<size_t>(RngSource::Passive)] += value;
+    m_drawCount[static_cast<size_t>(RngSource::Passive)]++;
+    return value;
+}
+
+template <class W, class P, class S, class D>
+double BasicSimulator<W, P, S, D>::drawWorkload(int userId) {
+    double value = m_commonRandom ? m_workloadDist->sample(drawStream(userId, RngSource::Workload))
+                                  : m_workloadDist->next(m_rng);
+    m_profiler.countRng(RngSource::Workload);
+    m_drawSum[static_cast<size_t>(RngSource::Workload)] += value;
+    m_drawCount[static_cast<size_t>(RngSource::Workload)]++;
+    return value;
+}
+
+template <class W, class P, class S, class D>
+void BasicSimulator<W, P, S, D>::setCommonRandomNumbers(bool enabled) {
+    if (m_initialized) throw std::logic_error("setCommonRandomNumbers must be called before the run starts");
+    m_commonRandom = enabled;
+}
+
+template <class W, class P, class S, class D>
+void BasicSimulator<W, P, S, D>::setPartitionMode() {
+    if (m_initialized) throw std::logic_error("setPartitionMode must be called before the run starts");
+    m_partition = true;
+}
+
+template <class W, class P, class S, class D>
+void BasicSimulator<W, P, S, D>::injectArrival(double time, int slot, double workload) {
+    if (!m_partition) throw std::logic_error("injectArrival needs partition mode");
+    if (slot < 0) throw std::out_of_range("injectArrival: bad slot");
+    if (time < m_currentTime) throw std::invalid_argument("injectArrival: arrival is in the past");
+    if (!m_initialized) initialize();
+    if (slot >= m_users) growSlots(slot + 1);
+    m_userTask[slot].workload = workload;
+    m_eventVersion[slot]++;
+    m_eventQueue.push(time, EventType::ACTIVATION, slot, m_eventVersion[slot]);
+}
+
+// Слоты узла кластера добавляются в конец: занятые не сдвигаются, а
+// resize растит ёмкость геометрически
+template <class W, class P, class S, class D>
+void BasicSimulator<W, P, S, D>::growSlots(int slots) {
+    const size_t n = static_cast<size_t>(slots);
+    m_userStates.resize(n, false);
+    m_userTask.resize(n, UserTask{0.0, 0.0});
+    m_eventVersion.resize(n, 0);
+    m_stats.timeInState.resize(n + 1, 0.0);
+    m_stats.users = slots;
+    m_users = slots;
+}
+
+template <class W, class P, class S, class D>
+void BasicSimulator<W, P, S, D>::setPerUserStats(bool enabled) {
+    if (m_initialized) throw std::logic_error("setPerUserStats must be called before the run starts");
+    m_perUserStats = enabled;
+}
+
+template <class W, class P, class S, class D>
+void BasicSimulator<W, P, S, D>::rescaleRemainingTimes(double oldRate, double newRate, int excludingUserId) {
     if (std::abs(oldRate - newRate) < 1e-12 || newRate <= 0.0) return;
     
     double ratio = oldRate / newRate;
     
     for (int uid = 0; uid < m_users; ++uid) {
         if (uid == excludingUserId) continue;
-        if (uid < 0 || uid >= m_users) continue;
-        if (!m_userStates[uid] || m_remainingTime[uid] <= 0.0) continue;
+        if (!m_userStates[uid] || !m_eventQueue.contains(uid)) continue;
         
-        m_remainingTime[uid] = std::max(0.0, m_remainingTime[uid] * ratio);
+        // Оставшееся время считаем от уже запланированного завершения и переносим само событие
+        double remaining = std::max(0.0, m_eventQueue.scheduledTime(uid) - m_currentTime);
+        m_eventQueue.reschedule(uid, m_currentTime + remaining * ratio);
+    }
+}
+
+template <class W, class P, class S, class D>
+void BasicSimulator<W, P, S, D>::deferRescale(double oldRate, double newRate) {
+    if (std::abs(oldRate - newRate) < 1e-12 || newRate <= 0.0) return;
+    // Немедленный перенос перенумеровал бы всех активных (их m_activeCount)
+    m_batchSteps.push_back({oldRate / newRate, m_eventQueue.reserveSequence(m_activeCount)});
+}
+
+// Пачка продолжается, пока следующее событие — активация в текущий момент.
+// Перед завершением в тот же момент отложенное применяется: порядок
+// одновременных завершений зависит от их перенумерации
+template <class W, class P, class S, class D>
+bool BasicSimulator<W, P, S, D>::continuesBatch() const {
+    if (m_eventQueue.empty()) return false;
+    const Event& next = m_eventQueue.peek();
+    return next.time == m_currentTime && next.type() == EventType::ACTIVATION;
+}
+
+template <class W, class P, class S, class D>
+void BasicSimulator<W, P, S, D>::flushBatch() {
+    if (m_completionPending) {
+        m_completionPending = false;
+        scheduleNextCompletion();
+    }
+    if (m_batchActivated.empty()) return;
+    
+    if (!m_batchSteps.empty()) {
+        // Активный до пачки пользователь проходит все шаги, активированный
+        // в пачке — шаги после своей активации. Номера постановки — из блока
+        // последнего шага в порядке userId, как у rescaleRemainingTimes
+        std::sort(m_batchActivated.begin(), m_batchActivated.end());
+        const size_t steps = m_batchSteps.size();
+        uint64_t sequence = m_batchSteps.back().firstSequence;
+        size_t next = 0;
+        for (int uid = 0; uid < m_users; ++uid) {
+            size_t first = 0;
+            if (next < m_batchActivated.size() && m_batchActivated[next].first == uid)
+                first = m_batchActivated[next++].second;
+            if (first >= steps || !m_userStates[uid] || !m_eventQueue.contains(uid)) continue;
+            
+            double time = m_eventQueue.scheduledTime(uid);
+            for (size_t s = first; s < steps; ++s) {
+                double remaining = std::max(0.0, time - m_currentTime);
+                time = m_currentTime + remaining * m_batchSteps[s].ratio;
+            }
+            m_eventQueue.reschedule(uid, time, sequence++);
+        }
+    }
+    m_batchSteps.clear();
+    m_batchActivated.clear();
+}
+
+template <class W, class P, class S, class D>
+void BasicSimulator<W, P, S, D>::advanceVirtualTime() {
+    if (m_engineMode != EngineMode::VirtualTime) return;
+    
+    if (m_virtualFinish.empty()) {
+        // Нет активных работ: сбрасываем виртуальные часы, чтобы не копить ошибку округления
+        m_virtualTime = 0.0;
+    } else {
+        m_virtualTime += m_currentEffectiveRate * (m_currentTime - m_virtualUpdateTime);
+    }
+    m_virtualUpdateTime = m_currentTime;
+}
+
+template <class W, class P, class S, class D>
+void BasicSimulator<W, P, S, D>::scheduleNextCompletion() {
+    if (m_virtualFinish.empty()) {
+        if (m_completionUser >= 0) m_eventQueue.cancel(m_completionUser);
+        m_completionUser = -1;
+        return;
     }
-}
\ No newline at end of file
+    
+    const Event& next = m_virtualFinish.peek();
+    if (m_completionUser >= 0 && m_completionUser != next.userId) {
+        m_eventQueue.cancel(m_completionUser);
+    }
+    
+    double delay = std::max(0.0, next.time - m_virtualTime) / m_currentEffectiveRate;
+    m_eventQueue.push(m_currentTime + delay, EventType::DEACTIVATION, next.userId, next.eventVersion);
+    m_completionUser = next.userId;
+}
+
+template class BasicSimulator<Distribution, Distribution, Distribution, std::function<double(double)>>;
+template class BasicSimulator<ExponentialDist, ExponentialDist, ExponentialDist, HyperbolicDegradation>;
+template class BasicSimulator<ExponentialDist, ExponentialDist, ExponentialDist, ExponentialDegradation>;
+template class BasicSimulator<ExponentialDist, ExponentialDist, ExponentialDist, LinearDegradation>;
+template class BasicSimulator<ExponentialDist, ExponentialDist, ExponentialDist, ThresholdDegradation>;
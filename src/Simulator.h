@@ -4,16 +4,22 @@
 #include "EventQueue.h"
 #include "Distribution.h"
 #include "ISimulationListener.h"
+#include "IStoppingRule.h"
+#include "Degradation.h"
+#include "BinaryIO.h"
+#include "Quantiles.h"
+#include "Profiler.h"
 
 #include <vector>
+#include <limits>
 #include <memory>
+#include <string>
 #include <algorithm>
 #include <numeric>
 #include <stdexcept>
 #include <iomanip>
 #include <iostream>
 #include <fstream>
-#include <map>
 #include <cstdint>
 
 struct SimulationStats {
@@ -23,25 +29,45 @@ struct SimulationStats {
     
     double nodeBusyTime = 0.0;
     int maxConcurrentUsers = 0;
-    int totalEventsProcessed = 0;
+    uint64_t totalEventsProcessed = 0;
     double totalSimulationTime = 0.0;
 
     std::vector<double> totalWorkCompleted;
     double totalWorkProcessed = 0.0;
     
-    std::map<int, double> completionTimeHistogram;
+    // Время отклика: от активации пользователя до завершения его задачи.
+    // Копии при расщеплении траекторий его не собирают (см. clone)
+    LatencyQuantiles completionTime;
+    bool recordLatency = true;
     
     double avgDegradationFactor = 1.0;
     int degradationSamples = 0;
 
     std::vector<double> timeInState;
 
-    explicit SimulationStats(int numUsers)
-        : totalActiveTime(numUsers, 0.0),
-          totalPassiveTime(numUsers, 0.0),
-          taskCount(numUsers, 0),
-          totalWorkCompleted(numUsers, 0.0),
-          timeInState(numUsers + 1, 0.0) {} 
+    // Без учёта по пользователям векторы выше пусты, а суммы по всем
+    // пользователям копятся здесь (средние делятся на users)
+    int users;
+    bool perUser = true;
+    double pooledActiveTime = 0.0;
+    double pooledPassiveTime = 0.0;
+    int64_t pooledTaskCount = 0;
+
+    explicit SimulationStats(int numUsers, bool perUserStats = true)
+        : timeInState(numUsers + 1, 0.0),
+          users(numUsers) {
+        setPerUser(perUserStats);
+    }
+
+    // Выделяет или освобождает векторы по пользователям; вызывать до прогона
+    void setPerUser(bool enabled) {
+        perUser = enabled;
+        size_t n = enabled ? static_cast<size_t>(users) : 0;
+        std::vector<double>(n, 0.0).swap(totalActiveTime);
+        std::vector<double>(n, 0.0).swap(totalPassiveTime);
+        std::vector<int>(n, 0).swap(taskCount);
+        std::vector<double>(n, 0.0).swap(totalWorkCompleted);
+    }
 
     std::vector<double> getProbabilityDistribution() const {
         std::vector<double> pk(timeInState.size(), 0.0);
@@ -52,6 +78,64 @@ struct SimulationStats {
         return pk;
     }
 
+    void save(std::ostream& out) const {
+        BinaryIO::writeVector(out, totalActiveTime);
+        BinaryIO::writeVector(out, totalPassiveTime);
+        BinaryIO::writeVector(out, taskCount);
+        BinaryIO::write(out, nodeBusyTime);
+        BinaryIO::write(out, maxConcurrentUsers);
+        BinaryIO::write(out, totalEventsProcessed);
+        BinaryIO::write(out, totalSimulationTime);
+        BinaryIO::writeVector(out, totalWorkCompleted);
+        BinaryIO::write(out, totalWorkProcessed);
+        completionTime.save(out);
+        BinaryIO::write(out, avgDegradationFactor);
+        BinaryIO::write(out, degradationSamples);
+        BinaryIO::writeVector(out, timeInState);
+        BinaryIO::write<uint8_t>(out, perUser ? 1 : 0);
+        BinaryIO::write(out, pooledActiveTime);
+        BinaryIO::write(out, pooledPassiveTime);
+        BinaryIO::write(out, pooledTaskCount);
+    }
+
+    void load(std::istream& in) {
+        totalActiveTime = BinaryIO::readVector<double>(in);
+        totalPassiveTime = BinaryIO::readVector<double>(in);
+        taskCount = BinaryIO::readVector<int>(in);
+        nodeBusyTime = BinaryIO::read<double>(in);
+        maxConcurrentUsers = BinaryIO::read<int>(in);
+        totalEventsProcessed = BinaryIO::read<uint64_t>(in);
+        totalSimulationTime = BinaryIO::read<double>(in);
+        totalWorkCompleted = BinaryIO::readVector<double>(in);
+        totalWorkProcessed = BinaryIO::read<double>(in);
+        completionTime.load(in);
+        avgDegradationFactor = BinaryIO::read<double>(in);
+        degradationSamples = BinaryIO::read<int>(in);
+        timeInState = BinaryIO::readVector<double>(in);
+        perUser = BinaryIO::read<uint8_t>(in) != 0;
+        pooledActiveTime = BinaryIO::read<double>(in);
+        pooledPassiveTime = BinaryIO::read<double>(in);
+        pooledTaskCount = BinaryIO::read<int64_t>(in);
+    }
+
+    // Завершение задачи: по пользователю или в общую сумму
+    void recordCompletion(int userId, double workload, double responseTime) {
+        if (perUser) {
+            taskCount[userId]++;
+            totalWorkCompleted[userId] += workload;
+        } else {
+            ++pooledTaskCount;
+        }
+        totalWorkProcessed += workload;
+        if (recordLatency) completionTime.add(responseTime);
+    }
+
+    size_t memoryBytes() const {
+        return totalActiveTime.capacity() * sizeof(double) + totalPassiveTime.capacity() * sizeof(double)
+             + taskCount.capacity() * sizeof(int) + totalWorkCompleted.capacity() * sizeof(double)
+             + timeInState.capacity() * sizeof(double);
+    }
+
     void recordDegradation(double factor) {
         avgDegradationFactor = (avgDegradationFactor * degradationSamples + factor) 
                               / (degradationSamples + 1);
@@ -65,23 +149,36 @@ struct SimulationStats {
     }
 
     double getAvgActiveTime() const {
+        if (!perUser) return users > 0 ? pooledActiveTime / users : 0.0;
         return totalActiveTime.empty() ? 0.0 
             : std::accumulate(totalActiveTime.begin(), totalActiveTime.end(), 0.0) 
               / totalActiveTime.size();
     }
 
     double getAvgPassiveTime() const {
+        if (!perUser) return users > 0 ? pooledPassiveTime / users : 0.0;
         return totalPassiveTime.empty() ? 0.0 
             : std::accumulate(totalPassiveTime.begin(), totalPassiveTime.end(), 0.0) 
               / totalPassiveTime.size();
     }
 
     double getAvgTaskCount() const {
+        if (!perUser) return users > 0 ? static_cast<double>(pooledTaskCount) / users : 0.0;
         return taskCount.empty() ? 0.0 
             : std::accumulate(taskCount.begin(), taskCount.end(), 0) 
               / static_cast<double>(taskCount.size());
     }
 
+    // Квантили времени отклика (общий формат для одиночного прогона и сводки прогонов)
+    static void printCompletionTime(const LatencyQuantiles& latency) {
+        std::cout << "Время отклика (" << latency.methodName() << ", n=" << latency.count() << "):\n"
+                  << "  среднее " << std::fixed << std::setprecision(3) << latency.mean()
+                  << "  p50 " << latency.quantile(0.50)
+                  << "  p95 " << latency.quantile(0.95)
+                  << "  p99 " << latency.quantile(0.99)
+                  << "  p99.9 " << latency.quantile(0.999) << " сек\n";
+    }
+
     void printSummary(int totalUsers) const {
         double utilization = getNodeUtilization(totalUsers);
         auto pk = getProbabilityDistribution();
@@ -100,8 +197,13 @@ struct SimulationStats {
         std::cout << "Среднее число задач:    " << std::fixed << std::setprecision(1) 
                   << getAvgTaskCount() << "\n";
         std::cout << "Обработано событий:     " << totalEventsProcessed << "\n";
+        printCompletionTime(completionTime);
         std::cout << "============================\n";
-        
+        printDistribution(pk);
+    }
+
+    // Таблица P(k) с гистограммой
+    static void printDistribution(const std::vector<double>& pk) {
         std::cout << "\nРаспределение числа активных пользователей P(k):\n";
         std::cout << " k |   P(k)   | Гистограмма\n";
         std::cout << "---|----------|------------\n";
@@ -116,59 +218,304 @@ struct SimulationStats {
     }
 };
 
-class Simulator {
+// Способ учёта изменения скорости обслуживания (processor sharing)
+enum class EngineMode {
+    Rescale,     // перемасштабирование оставшихся времён всех активных: O(N) на событие
+    VirtualTime, // виртуальные часы обслуживания: O(log N) на событие
+    Lumped       // агрегированные пользователи (только экспоненциальные простой
+                 // и обслуживание): одно событие на узел, O(1) на событие
+};
+
+// Узел кластера (режим раздела, см. Cluster.h): уход задачи с узла и
+// состояние узла после события
+struct Departure {
+    double time;
+    int slot;
+};
+
+struct NodeState {
+    double time;
+    int activeCount;
+    double totalWorkload;
+};
+
+// Симулятор, параметризованный типами распределений и функции деградации.
+// Для конкретных (final) типов вызовы в горячем цикле разрешаются статически
+// и встраиваются; обобщённый вариант Simulator работает через виртуальные
+// Distribution и std::function. Определения — в Simulator.cpp, набор
+// специализаций фиксирован явными инстанцированиями в конце этого файла.
+template <class WorkloadDist, class PassiveDist, class ServiceDist, class DegradationFn>
+class BasicSimulator {
 private:
-    const int m_users;
+    int m_users;  // на узле кластера — число слотов задач, растёт по мере надобности
     
     double m_currentTime = 0.0;
     double m_statUpdateTime = 0.0;
     double m_baseServiceRate;
     double m_currentEffectiveRate;
     
-    std::unique_ptr<Distribution> m_workloadDist;
-    std::unique_ptr<Distribution> m_passiveTimeDist;
-    std::unique_ptr<Distribution> m_serviceTime;
-    std::function<double(double)> m_degradationFn;
+    ClonePtr<WorkloadDist> m_workloadDist;
+    ClonePtr<PassiveDist> m_passiveTimeDist;
+    ClonePtr<ServiceDist> m_serviceTime;
+    DegradationFn m_degradationFn;
+    std::string m_degradationName;  // для проверки контрольной точки (у функции имени нет)
+    RandomGenerator m_rng;  // собственный поток случайных чисел симуляции
+    
+    // Состояние пользователей (см. allocateUserState). Поля, которые
+    // обработчик события читает вместе, лежат в одной записи: 16 байт,
+    // по четыре пользователя на строку кэша
+    struct UserTask {
+        double workload;        // объём работы текущей задачи
+        double activationTime;  // момент её активации
+    };
+    std::vector<bool> m_userStates;        // упакованный битсет: активен ли пользователь
+    std::vector<UserTask> m_userTask;
+    std::vector<uint32_t> m_eventVersion;
+    std::vector<double> m_lastEventTime;   // только при учёте по пользователям
     
-    std::vector<bool> m_userStates;
-    std::vector<double> m_lastEventTime;
-    std::vector<double> m_Workload;
-    std::vector<double> m_remainingTime;
-    std::vector<uint64_t> m_eventVersion;
+    // Инкрементальные агрегаты вместо пересчёта по всем пользователям
+    int m_activeCount = 0;
+    double m_totalWorkload = 0.0;
+    double m_workloadCompensation = 0.0;  // компенсация ошибки округления суммы
     
     SimulationStats m_stats;
     EventQueue m_eventQueue;
+    
+    // Режим виртуального времени: V(t) = ∫ rate dt, завершение пользователя — момент V = finish
+    EngineMode m_engineMode = EngineMode::Rescale;
+    double m_virtualTime = 0.0;
+    double m_virtualUpdateTime = 0.0;
+    EventQueue m_virtualFinish;   // ключ — виртуальное время завершения
+    int m_completionUser = -1;    // чьё завершение сейчас стоит в m_eventQueue
+    
+    // Пачка одновременных событий. Перенос завершений при активации (Rescale)
+    // и планирование ближайшего завершения (VirtualTime) откладываются, пока
+    // следующее событие — активация в тот же момент, и выполняются один раз.
+    // Каждый шаг переноса запоминается и потом повторяется теми же операциями
+    // с плавающей точкой, поэтому результат совпадает с пособытийным до бита
+    struct RescaleStep {
+        double ratio;             // старая скорость / новая
+        uint64_t firstSequence;   // номера постановки, которые получил бы немедленный перенос
+    };
+    std::vector<RescaleStep> m_batchSteps;
+    std::vector<std::pair<int, size_t>> m_batchActivated; // (пользователь, шагов до его активации)
+    bool m_completionPending = false;
+    
+    // Агрегированный режим. Простой и обслуживание без памяти, поэтому
+    // суперпозиция событий пользователей — один пуассоновский поток с
+    // интенсивностью n_idle·λ + k·μ(R): в m_eventQueue стоит единственное
+    // системное событие, его тип выбирается пропорционально слагаемым.
+    // Активные задачи — неупорядоченный набор, завершается равновероятная
+    struct LumpedTask {
+        double workload;
+        double activationTime;
+        int userId;               // -1 без учёта по пользователям
+    };
+    std::vector<LumpedTask> m_lumpedTasks;
+    std::vector<int> m_idleUsers; // простаивающие (только при учёте по пользователям)
+    double m_passiveRate = 0.0;   // λ экспоненциального простоя
+    bool m_perUserStats = true;
+    
+    // Режим раздела кластера: пользователи не простаивают на узле, задачи
+    // приходят от диспетчера с готовым объёмом работы, завершения уходят
+    // в m_departures, а состояние после каждого события — в m_stateLog
+    bool m_partition = false;
+    std::vector<Departure> m_departures;
+    std::vector<NodeState> m_stateLog;
+    
+    // Общие случайные числа: у пользователя свои подпотоки простоя, объёма
+    // работы и обслуживания (индекс 3·userId + RngSource), поэтому
+    // сравниваемые сценарии получают одни и те же величины при любом
+    // порядке событий. Суммы выданных величин — для управляющих переменных
+    static constexpr size_t kRngSources = static_cast<size_t>(RngSource::Count);
+    bool m_commonRandom = false;
+    std::vector<RandomGenerator> m_userRng;
+    double m_drawSum[kRngSources] = {};
+    uint64_t m_drawCount[kRngSources] = {};
+    
+    RandomGenerator& drawStream(int userId, RngSource source) {
+        return m_commonRandom ? m_userRng[3 * static_cast<size_t>(userId) + static_cast<size_t>(source)] : m_rng;
+    }
+    double drawPassive(int userId);
+    double drawWorkload(int userId);
 
     void updateGlobalStatistics(double currentTime);
     void updateStatistics(int userId, double currentTime);
     void handleActivation(int userId);
     void handleDeactivation(int userId);
+    void handleLumpedActivation();
+    void handleLumpedCompletion();
+    void scheduleLumpedEvent();
+    void checkLumpedDistributions();
+    void allocateUserState();
+    void growSlots(int slots);
+    
+    // Мониторинг: тики каждые m_monitorInterval и (если задано) окна агрегации
+    double m_monitorInterval = 1.0;
+    double m_nextMonitorTime = 0.0;
+    double m_windowLength = 0.0;     // 0 — окна выключены, слушатели получают снимки
+    double m_windowStart = 0.0;
+    double m_windowUpdateTime = 0.0;
+    double m_windowActiveIntegral = 0.0;
+    double m_windowRateIntegral = 0.0;
+    int m_windowMinActive = 0;
+    int m_windowMaxActive = 0;
+    double m_windowMinRate = 0.0;
+    double m_windowMaxRate = 0.0;
+    
     void handleMonitoring();
-    void scheduleMonitoring(double nextTime);
+    void monitorUntil(double time);
+    void advanceWindow(double time);
+    void resetWindow(double start);
+    void observeWindowState();
 
     std::vector<ISimulationListener*> m_listeners;
     void notifyListeners();
     
+    IStoppingRule* m_stoppingRule = nullptr;
+    bool m_stopRequested = false;
+    // Наблюдение за уровнем: runUntil останавливается сразу после события,
+    // выводящего число активных из [m_watchLow, m_watchHigh)
+    int m_watchLow = std::numeric_limits<int>::min();
+    int m_watchHigh = std::numeric_limits<int>::max();
+    bool m_initialized = false;   // начальные активации уже запланированы
+    
+    Profiler m_profiler;          // пуст без SIMULATOR_PROFILE
+    
     double getTotalWorkload() const;
-    double computeEffectiveRate(double totalWorkload) const;
+    void addToTotalWorkload(double delta);
     void rescaleRemainingTimes(double oldRate, double newRate, int excludingUserId = -1);
+    void deferRescale(double oldRate, double newRate);
+    bool continuesBatch() const;
+    void flushBatch();
+    void advanceVirtualTime();
+    void scheduleNextCompletion();
+    
+    // Копирование — только через clone()
+    BasicSimulator(const BasicSimulator&) = default;
+    BasicSimulator& operator=(const BasicSimulator&) = delete;
     
 public:
-    Simulator(
+    BasicSimulator(
         int maxUsers,
         double baseServiceRate,
-        std::unique_ptr<Distribution> workloadDist,
-        std::unique_ptr<Distribution> passiveTimeDist,
-        std::unique_ptr<Distribution> serviceTimeDist,
-        std::function<double(double)> degradationFn
+        std::unique_ptr<WorkloadDist> workloadDist,
+        std::unique_ptr<PassiveDist> passiveTimeDist,
+        std::unique_ptr<ServiceDist> serviceTimeDist,
+        DegradationFn degradationFn,
+        RandomGenerator rng = RandomGenerator()
     );
     
+    void setEngineMode(EngineMode mode);
+    // Метод оценки квантилей времени отклика; вызывать до запуска
+    void setQuantileMethod(QuantileMethod method) { m_stats.completionTime = LatencyQuantiles(method); }
+    // Имя функции деградации: пишется в контрольную точку и сверяется при загрузке
+    void setDegradationName(std::string name) { m_degradationName = std::move(name); }
+    EngineMode engineMode() const { return m_engineMode; }
+    // Учёт времени и числа задач по каждому пользователю. Без него остаются
+    // только суммы по всем пользователям, а в агрегированном режиме, кроме
+    // того, не выбирается активирующийся пользователь и память под
+    // пользователей не выделяется. Вызывать до запуска
+    void setPerUserStats(bool enabled);
+    bool perUserStats() const { return m_perUserStats; }
+    
+    // Узел кластера: вызывать до запуска. Задачи приходят только через
+    // injectArrival (time не раньше текущего момента), а завершения и журнал
+    // состояний забирает и очищает вызывающий между runUntil. Вместо
+    // пользователей узел знает слоты: номера выдаёт вызывающий (свободный
+    // слот можно занять после ухода его задачи), а состояние растёт до
+    // наибольшего слота, т.е. по числу задач на узле, а не пользователей
+    void setPartitionMode();
+    void injectArrival(double time, int slot, double workload);
+    std::vector<Departure>& departures() { return m_departures; }
+    std::vector<NodeState>& stateLog() { return m_stateLog; }
+    // Время ближайшего запланированного события (бесконечность, если их нет)
+    double nextEventTime() const {
+        return m_eventQueue.empty() ? std::numeric_limits<double>::infinity() : m_eventQueue.peek().time;
+    }
+    
+    // Общие случайные числа для парных сравнений: свой подпоток на
+    // пользователя и величину, экспонента — обращением функции
+    // распределения. Антитетический прогон: тот же поток ГСЧ с
+    // setAntithetic(true). Вызывать до запуска; несовместимо с lumped
+    void setCommonRandomNumbers(bool enabled);
+    bool commonRandomNumbers() const { return m_commonRandom; }
+    // Среднее выданных с начала прогона величин (простоя, объёма работы)
+    double drawnMean(RngSource source) const {
+        size_t i = static_cast<size_t>(source);
+        return m_drawCount[i] ? m_drawSum[i] / static_cast<double>(m_drawCount[i]) : 0.0;
+    }
+    
+    // μ₀·f(R): эффективная скорость узла при суммарном объёме работы R
+    double computeEffectiveRate(double totalWorkload) const;
+    
     void initialize();
+    
+    // Интервал тиков мониторинга (снимки слушателям и опрос правила остановки)
+    void setMonitorInterval(double interval);
+    // Длина окна агрегации; > 0 — слушатели получают onWindow с взвешенными
+    // по времени средним/минимумом/максимумом вместо точечных снимков
+    void setAggregationWindow(double length);
+    
+    // Обрабатывает события со временем < endTime и подводит статистику
+    // к endTime. Повторный вызов продолжает с достигнутого момента
     void runUntil(double endTime);
     double currentTime() const { return m_currentTime; }
     const SimulationStats& getStats() const { return m_stats; }
+    // Память под состояние прогона, зависящее от числа пользователей:
+    // пользователи, очереди событий и статистика (по ёмкости векторов)
+    size_t stateBytes() const;
+    RandomGenerator& rng() { return m_rng; }
     void attachListener(ISimulationListener* listener);
+    
+    // Правило досрочной остановки; endTime в runUntil становится верхней границей
+    void setStoppingRule(IStoppingRule* rule) { m_stoppingRule = rule; }
+    bool stoppedEarly() const { return m_stopRequested; }
+    
+    // Расщепление траекторий (Splitting.h). clone — копия всего состояния
+    // прогона (O(N + очередь событий), в агрегированном режиме без учёта по
+    // пользователям — O(k)) с потоком ГСЧ rng; слушатели и правило остановки
+    // не копируются. В агрегированном режиме следующее событие копии
+    // разыгрывается заново, в остальных уже выбранные моменты событий общие с
+    // оригиналом. Несовместимо с общими случайными числами: подпотоки
+    // пользователей повторили бы исходную траекторию. Времена отклика копия
+    // не собирает: повторные испытания входят в оценки с весами.
+    // setLevelWatch(low, high): runUntil останавливается сразу после события,
+    // после которого число активных k < low или k ≥ high
+    std::unique_ptr<BasicSimulator> clone(RandomGenerator rng);
+    void setLevelWatch(int low, int high) {
+        m_watchLow = low;
+        m_watchHigh = high;
+    }
+    int activeCount() const { return m_activeCount; }
+    
+    // Счётчики горячего пути (--profile); собираются только в сборке с SIMULATOR_PROFILE
+    Profiler& profiler() { return m_profiler; }
+    
+    // Полное состояние прогона в двоичном виде: пользователи, очереди событий,
+    // статистика, ГСЧ и буферы распределений. Распределения и функция
+    // деградации не сохраняются — симулятор должен быть собран с теми же
+    // параметрами (число пользователей, режим и имена распределений сверяются)
+    void saveCheckpoint(const std::string& path) const;
+    void loadCheckpoint(const std::string& path);
+    
+    // Сверка инкрементальных агрегатов с полным пересчётом (O(N));
+    // в Debug-сборке вызывается после каждого события
+    void checkInvariants() const;
     void finalize();
 };
 
+// Обобщённый симулятор: любые распределения и функция деградации
+using Simulator = BasicSimulator<Distribution, Distribution, Distribution, std::function<double(double)>>;
+
+// Специализации для экспоненциальных объёма работы, простоя и обслуживания
+template <class DegradationFn>
+using ExponentialSimulator = BasicSimulator<ExponentialDist, ExponentialDist, ExponentialDist, DegradationFn>;
+
+extern template class BasicSimulator<Distribution, Distribution, Distribution, std::function<double(double)>>;
+extern template class BasicSimulator<ExponentialDist, ExponentialDist, ExponentialDist, HyperbolicDegradation>;
+extern template class BasicSimulator<ExponentialDist, ExponentialDist, ExponentialDist, ExponentialDegradation>;
+extern template class BasicSimulator<ExponentialDist, ExponentialDist, ExponentialDist, LinearDegradation>;
+extern template class BasicSimulator<ExponentialDist, ExponentialDist, ExponentialDist, ThresholdDegradation>;
+
 #endif
\ No newline at end of file
@@ -0,0 +1,188 @@
+// === SnapshotFormat.h ===
+#pragma once
+#include "ISimulationListener.h"
+
+#include <fstream>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+// Двоичный колоночный формат снимков мониторинга (.bin).
+//
+// Все числа — little-endian фиксированной ширины.
+//   Заголовок (48 байт):
+//     char[8]  magic "SRWSNAP1"
+//     uint32   version (2)
+//     uint32   columns (4)
+//     uint32   rowsPerBlock — максимальное число строк в блоке
+//     uint32   reserved
+//     uint64   indexOffset — смещение индекса блоков (0, если файл не закрыт)
+//     uint64   totalRows
+//     double   baseRate — μ₀
+//   Блоки, по колонке подряд:
+//     uint32   rows
+//     double[rows] time
+//     int32[rows]  active_users
+//     double[rows] total_workload
+//     double[rows] effective_rate
+//   degradation_factor не хранится: это effective_rate / μ₀, и Block::row
+//   восстанавливает его тем же делением, что и симулятор, — до бита
+//   Индекс блоков:
+//     uint64   blockCount
+//     { uint64 offset; uint64 rows; double firstTime; double lastTime } × blockCount
+namespace SnapshotFormat {
+
+constexpr char kMagic[8] = {'S', 'R', 'W', 'S', 'N', 'A', 'P', '1'};
+constexpr uint32_t kVersion = 2;
+constexpr uint32_t kColumns = 4;
+constexpr size_t kHeaderSize = 48;
+constexpr size_t kIndexOffsetPosition = 24;
+
+struct BlockInfo {
+    uint64_t offset;
+    uint64_t rows;
+    double firstTime;
+    double lastTime;
+};
+
+inline bool hostIsLittleEndian() {
+    const uint16_t probe = 1;
+    unsigned char first;
+    std::memcpy(&first, &probe, 1);
+    return first == 1;
+}
+
+// Массив значений в little-endian; на little-endian хосте — одной записью
+template <class T>
+void writeArray(std::ostream& out, const T* values, size_t n) {
+    if (hostIsLittleEndian()) {
+        out.write(reinterpret_cast<const char*>(values), static_cast<std::streamsize>(n * sizeof(T)));
+        return;
+    }
+    for (size_t i = 0; i < n; ++i) {
+        unsigned char bytes[sizeof(T)];
+        std::memcpy(bytes, &values[i], sizeof(T));
+        for (size_t b = 0; b < sizeof(T) / 2; ++b) std::swap(bytes[b], bytes[sizeof(T) - 1 - b]);
+        out.write(reinterpret_cast<const char*>(bytes), sizeof(T));
+    }
+}
+
+template <class T>
+void readArray(std::istream& in, T* values, size_t n) {
+    if (!in.read(reinterpret_cast<char*>(values), static_cast<std::streamsize>(n * sizeof(T))))
+        throw std::runtime_error("Truncated snapshot file");
+    if (hostIsLittleEndian()) return;
+    for (size_t i = 0; i < n; ++i) {
+        unsigned char bytes[sizeof(T)];
+        std::memcpy(bytes, &values[i], sizeof(T));
+        for (size_t b = 0; b < sizeof(T) / 2; ++b) std::swap(bytes[b], bytes[sizeof(T) - 1 - b]);
+        std::memcpy(&values[i], bytes, sizeof(T));
+    }
+}
+
+template <class T>
+void writeValue(std::ostream& out, T value) { writeArray(out, &value, 1); }
+
+template <class T>
+T readValue(std::istream& in) {
+    T value;
+    readArray(in, &value, 1);
+    return value;
+}
+
+// Колонки одного блока
+struct Block {
+    std::vector<double> time;
+    std::vector<int32_t> activeUsers;
+    std::vector<double> totalWorkload;
+    std::vector<double> effectiveRate;
+    double baseRate = 1.0;  // μ₀ из заголовка файла
+
+    size_t size() const { return time.size(); }
+
+    void reserve(size_t n) {
+        time.reserve(n);
+        activeUsers.reserve(n);
+        totalWorkload.reserve(n);
+        effectiveRate.reserve(n);
+    }
+
+    void clear() {
+        time.clear();
+        activeUsers.clear();
+        totalWorkload.clear();
+        effectiveRate.clear();
+    }
+
+    void append(const SimulationSnapshot& s) {
+        time.push_back(s.time);
+        activeUsers.push_back(s.activeUsers);
+        totalWorkload.push_back(s.totalWorkload);
+        effectiveRate.push_back(s.effectiveRate);
+    }
+
+    SimulationSnapshot row(size_t i) const {
+        return {time[i], activeUsers[i], totalWorkload[i], effectiveRate[i], effectiveRate[i] / baseRate};
+    }
+};
+
+// Чтение .bin: индекс блоков загружается сразу, блоки — по запросу
+class Reader {
+    std::ifstream m_in;
+    uint32_t m_rowsPerBlock = 0;
+    uint64_t m_totalRows = 0;
+    double m_baseRate = 1.0;
+    std::vector<BlockInfo> m_index;
+
+public:
+    explicit Reader(const std::string& path) : m_in(path, std::ios::binary) {
+        if (!m_in) throw std::runtime_error("Cannot open snapshot file: " + path);
+
+        char magic[sizeof(kMagic)];
+        if (!m_in.read(magic, sizeof(magic)) || std::memcmp(magic, kMagic, sizeof(kMagic)) != 0)
+            throw std::runtime_error("Not a binary snapshot file: " + path);
+        if (readValue<uint32_t>(m_in) != kVersion) throw std::runtime_error("Unsupported snapshot version");
+        if (readValue<uint32_t>(m_in) != kColumns) throw std::runtime_error("Unexpected snapshot column count");
+        m_rowsPerBlock = readValue<uint32_t>(m_in);
+        readValue<uint32_t>(m_in);
+        uint64_t indexOffset = readValue<uint64_t>(m_in);
+        m_totalRows = readValue<uint64_t>(m_in);
+        m_baseRate = readValue<double>(m_in);
+        if (indexOffset == 0) throw std::runtime_error("Snapshot file was not closed (no block index): " + path);
+
+        m_in.seekg(static_cast<std::streamoff>(indexOffset));
+        m_index.resize(readValue<uint64_t>(m_in));
+        for (auto& block : m_index) {
+            block.offset = readValue<uint64_t>(m_in);
+            block.rows = readValue<uint64_t>(m_in);
+            block.firstTime = readValue<double>(m_in);
+            block.lastTime = readValue<double>(m_in);
+        }
+    }
+
+    uint64_t totalRows() const { return m_totalRows; }
+    uint32_t rowsPerBlock() const { return m_rowsPerBlock; }
+    double baseRate() const { return m_baseRate; }
+    const std::vector<BlockInfo>& index() const { return m_index; }
+
+    void readBlock(size_t i, Block& block) {
+        const BlockInfo& info = m_index.at(i);
+        m_in.seekg(static_cast<std::streamoff>(info.offset));
+        uint32_t rows = readValue<uint32_t>(m_in);
+        if (rows != info.rows) throw std::runtime_error("Snapshot block index mismatch");
+        block.time.resize(rows);
+        block.activeUsers.resize(rows);
+        block.totalWorkload.resize(rows);
+        block.effectiveRate.resize(rows);
+        block.baseRate = m_baseRate;
+        readArray(m_in, block.time.data(), rows);
+        readArray(m_in, block.activeUsers.data(), rows);
+        readArray(m_in, block.totalWorkload.data(), rows);
+        readArray(m_in, block.effectiveRate.data(), rows);
+    }
+};
+
+} // namespace SnapshotFormat
@@ -0,0 +1,269 @@
+// === Splitting.h ===
+#pragma once
+#include "Simulator.h"
+#include "Statistics.h"
+#include "RandomGenerator.h"
+
+#include <vector>
+#include <string>
+#include <optional>
+#include <algorithm>
+#include <limits>
+#include <cstdint>
+#include <cmath>
+#include <stdexcept>
+#include <iostream>
+#include <iomanip>
+
+// Порог расщепления: при подъёме числа активных до threshold траектория
+// порождает factor − 1 повторных испытаний
+struct RestartLevel {
+    int threshold;
+    int factor;
+};
+
+// Один прогон длительности T: RESTART или обычная симуляция
+struct SplittingRun {
+    std::vector<double> pk;
+    // Оценка числа подъёмов одной траектории до k (только на порогах,
+    // иначе NaN): для нижней границы затрат обычной симуляции
+    std::vector<double> upCrossings;
+    uint64_t retrials = 0;  // запущено повторных испытаний
+    uint64_t events = 0;    // событий во всех траекториях
+    double seconds = 0.0;   // затраты на прогон
+};
+
+// Расщепление траекторий RESTART (Villén-Altamirano) для хвоста P(k).
+// Функция важности — число активных k, пороги L_1 < … < L_m. Траектория,
+// поднявшаяся до L_i, продолжается, а из того же состояния запускаются
+// R_i − 1 повторных испытаний (копии симулятора со своими подпотоками
+// ГСЧ). Повторное испытание уровня i гибнет, опустившись ниже L_i, и само
+// расщепляется на следующих порогах; основная траектория идёт до конца.
+// Время всех траекторий в состоянии k, делённое на Π R_j по порогам
+// L_j ≤ k, в среднем равно времени одной траектории, поэтому
+// P̂(k) = время(k) / (Π R_j · T) — несмещённая оценка при любых R_j.
+// Выбор порогов и R_j влияет только на дисперсию и стоимость.
+template <class Sim>
+class RestartSplitting {
+    std::vector<RestartLevel> m_levels;
+    RandomGenerator m_streams;
+    uint64_t m_nextStream = 0;
+    std::vector<double> m_time;        // время всех траекторий в состоянии k
+    std::vector<uint64_t> m_crossings; // подъёмов всех траекторий до порога i
+    SplittingRun m_run;
+
+    // Число порогов, не превышающих k
+    size_t levelOf(int k) const {
+        size_t level = 0;
+        while (level < m_levels.size() && m_levels[level].threshold <= k) ++level;
+        return level;
+    }
+
+    // Вклад траектории с момента, когда её статистика была before
+    void accumulate(const SimulationStats& stats, const std::vector<double>* before, uint64_t eventsBefore) {
+        for (size_t k = 0; k < m_time.size(); ++k)
+            m_time[k] += stats.timeInState[k] - (before ? (*before)[k] : 0.0);
+        m_run.events += stats.totalEventsProcessed - eventsBefore;
+    }
+
+    // Траектория, рождённая на пороге birth (0 — основная), идёт до endTime
+    // или до спуска ниже своего порога. Остановка нужна на каждом пороге в
+    // обе стороны: иначе повторный подъём после спуска не был бы замечен.
+    // Повторные испытания обходятся в глубину, поэтому одновременно живёт
+    // не больше m + 1 копий
+    void runTrajectory(Sim& sim, size_t birth, double endTime) {
+        constexpr int kNone = std::numeric_limits<int>::max();
+        auto threshold = [&](size_t level) { return level > 0 ? m_levels[level - 1].threshold : -kNone; };
+        const int low = threshold(birth);
+        for (;;) {
+            size_t level = levelOf(sim.activeCount());
+            int high = level < m_levels.size() ? m_levels[level].threshold : kNone;
+            sim.setLevelWatch(threshold(level), high);
+            sim.runUntil(endTime);
+            if (!sim.stoppedEarly() || sim.activeCount() < low) return;
+            if (sim.activeCount() < threshold(level)) continue;  // спуск на уровень ниже
+
+            ++m_crossings[level];
+            for (int r = 1; r < m_levels[level].factor; ++r) {
+                if (m_nextStream >= (uint64_t(1) << 32))
+                    throw std::runtime_error("Splitting exhausted 2^32 retrial streams; lower the factors");
+                auto retrial = sim.clone(m_streams.substream(m_nextStream++));
+                const std::vector<double> before = retrial->getStats().timeInState;
+                const uint64_t eventsBefore = retrial->getStats().totalEventsProcessed;
+                runTrajectory(*retrial, level + 1, endTime);
+                accumulate(retrial->getStats(), &before, eventsBefore);
+                ++m_run.retrials;
+            }
+        }
+    }
+
+public:
+    // streams — поток ГСЧ прогона: повторные испытания берут его подпотоки
+    RestartSplitting(std::vector<RestartLevel> levels, RandomGenerator streams)
+        : m_levels(std::move(levels)), m_streams(std::move(streams)) {
+        for (size_t i = 0; i < m_levels.size(); ++i) {
+            if (m_levels[i].factor < 1) throw std::invalid_argument("Splitting factor must be >= 1");
+            if (i > 0 && m_levels[i].threshold <= m_levels[i - 1].threshold)
+                throw std::invalid_argument("Splitting thresholds must increase");
+        }
+    }
+
+    // Прогон основной траектории sim до endTime со всеми повторными испытаниями
+    SplittingRun run(Sim& sim, double endTime) {
+        const size_t states = sim.getStats().timeInState.size();
+        m_time.assign(states, 0.0);
+        m_crossings.assign(m_levels.size(), 0);
+        m_run = SplittingRun{};
+        runTrajectory(sim, 0, endTime);
+        accumulate(sim.getStats(), nullptr, 0);
+
+        // Подъёмы до L_i совершают траектории с весом Π R_j по j < i
+        m_run.pk.assign(states, 0.0);
+        m_run.upCrossings.assign(states, std::numeric_limits<double>::quiet_NaN());
+        double weight = 1.0;
+        size_t level = 0;
+        for (size_t k = 0; k < states; ++k) {
+            while (level < m_levels.size() && m_levels[level].threshold <= static_cast<int>(k)) {
+                if (m_levels[level].threshold == static_cast<int>(k))
+                    m_run.upCrossings[k] = static_cast<double>(m_crossings[level]) / weight;
+                weight *= m_levels[level++].factor;
+            }
+            m_run.pk[k] = m_time[k] / (weight * endTime);
+        }
+        return m_run;
+    }
+};
+
+// Сравнение RESTART с обычной симуляцией по R независимым прогонам каждого
+// метода одинаковой длительности T. Относительная ошибка (RE) — отношение
+// полуширины 95% ДИ к оценке. RE² обратно пропорциональна затратам, поэтому
+// ускорение при той же RE — (RE²·затраты) обычной / (RE²·затраты) RESTART.
+// Если обычная симуляция событие не видела, её затраты оцениваются снизу:
+// при ν входах в множество за секунду модели даже независимые пребывания
+// дают RE не меньше z/√(ν·T), а разброс длительностей и группировка
+// пребываний её только увеличивают
+class SplittingSummary {
+    int m_users;
+    double m_simTime;
+    std::vector<RestartLevel> m_levels;
+    std::vector<SplittingRun> m_split;
+    std::vector<SplittingRun> m_crude;
+
+    static double seconds(const std::vector<SplittingRun>& runs) {
+        double sum = 0.0;
+        for (const auto& run : runs) sum += run.seconds;
+        return sum;
+    }
+
+    static uint64_t events(const std::vector<SplittingRun>& runs) {
+        uint64_t sum = 0;
+        for (const auto& run : runs) sum += run.events;
+        return sum;
+    }
+
+    // P(k ≥ from) по прогонам
+    static Stats::MeanCI tail(const std::vector<SplittingRun>& runs, int from) {
+        std::vector<double> values;
+        for (const auto& run : runs) {
+            double sum = 0.0;
+            for (size_t k = static_cast<size_t>(from); k < run.pk.size(); ++k) sum += run.pk[k];
+            values.push_back(sum);
+        }
+        return Stats::meanCI(values);
+    }
+
+    static Stats::MeanCI column(const std::vector<SplittingRun>& runs, int k) {
+        std::vector<double> values;
+        for (const auto& run : runs) values.push_back(run.pk[static_cast<size_t>(k)]);
+        return Stats::meanCI(values);
+    }
+
+    // Ускорение при той же RE для P(k ≥ from); nullopt — оценить нельзя,
+    // lowerBound — получена нижняя граница по числу входов
+    std::optional<double> speedup(const Stats::MeanCI& split, const Stats::MeanCI& crude, int from,
+                                  bool& lowerBound) const {
+        lowerBound = false;
+        if (!(split.mean > 0.0) || !(split.halfWidth > 0.0)) return std::nullopt;
+        const double splitWork = split.relativeHalfWidth() * split.relativeHalfWidth() * seconds(m_split);
+        if (crude.mean > 0.0 && crude.halfWidth > 0.0)
+            return crude.relativeHalfWidth() * crude.relativeHalfWidth() * seconds(m_crude) / splitWork;
+
+        double entries = 0.0;
+        for (const auto& run : m_split) entries += run.upCrossings[static_cast<size_t>(from)];
+        if (!(entries > 0.0)) return std::nullopt;
+        const double entryRate = entries / (static_cast<double>(m_split.size()) * m_simTime);
+        const double crudeTime = static_cast<double>(m_crude.size()) * m_simTime;
+        const double z = Stats::studentT975(static_cast<int>(m_crude.size()) - 1);
+        lowerBound = true;
+        return z * z / (entryRate * crudeTime) * seconds(m_crude) / splitWork;
+    }
+
+public:
+    SplittingSummary(int users, double simTime, std::vector<RestartLevel> levels)
+        : m_users(users), m_simTime(simTime), m_levels(std::move(levels)) {}
+
+    // Прогоны добавляются по номерам — итог, кроме затрат, не зависит от
+    // числа потоков
+    void addSplit(SplittingRun run) { m_split.push_back(std::move(run)); }
+    void addCrude(SplittingRun run) { m_crude.push_back(std::move(run)); }
+
+    // Среднее по прогонам RESTART (для --csv)
+    std::vector<double> meanProbabilityDistribution() const {
+        std::vector<double> pk(static_cast<size_t>(m_users) + 1, 0.0);
+        for (size_t k = 0; k < pk.size(); ++k) pk[k] = column(m_split, static_cast<int>(k)).mean;
+        return pk;
+    }
+
+    void printSummary() const {
+        uint64_t retrials = 0;
+        for (const auto& run : m_split) retrials += run.retrials;
+        std::cout << "\n=== Расщепление RESTART: хвост P(k) (95% ДИ) ===\n";
+        std::cout << "Пороги (k: R):          ";
+        for (size_t i = 0; i < m_levels.size(); ++i)
+            std::cout << (i ? ", " : "") << m_levels[i].threshold << ": " << m_levels[i].factor;
+        std::cout << "\n";
+        std::cout << "Прогонов на метод:      " << m_split.size() << "\n";
+        std::cout << "Повторных испытаний:    " << retrials << "\n";
+        std::cout << "Событий: RESTART " << events(m_split) << ", обычная " << events(m_crude) << "\n";
+        std::cout << "Затраты: RESTART " << std::fixed << std::setprecision(3) << seconds(m_split)
+                  << " сек, обычная " << seconds(m_crude) << " сек\n";
+
+        auto line = [&](const char* label, int from) {
+            Stats::MeanCI split = tail(m_split, from);
+            Stats::MeanCI crude = tail(m_crude, from);
+            std::cout << label << std::scientific << std::setprecision(3)
+                      << "RESTART " << split.mean << " ± " << split.halfWidth
+                      << " (RE " << std::fixed << std::setprecision(3) << split.relativeHalfWidth() << ")"
+                      << std::scientific << std::setprecision(3) << ", обычная " << crude.mean;
+            if (crude.mean > 0.0) {
+                std::cout << " ± " << crude.halfWidth << " (RE " << std::fixed << std::setprecision(3)
+                          << crude.relativeHalfWidth() << ")";
+            } else {
+                std::cout << " (не наблюдалось)";
+            }
+            bool lowerBound = false;
+            auto gain = speedup(split, crude, from, lowerBound);
+            if (gain) {
+                std::cout << ", ускорение " << (lowerBound ? "≥ ×" : "×")
+                          << std::fixed << std::setprecision(1) << *gain << "\n";
+            } else {
+                std::cout << ", ускорение не оценить\n";
+            }
+        };
+        line("P(k = N):               ", m_users);
+        if (m_users >= 2) line("P(k ≥ N−1):             ", m_users - 1);
+        std::cout << "============================\n";
+
+        std::cout << "\n k |  RESTART P(k)  |  ± ДИ     | обычная P(k)\n";
+        std::cout << "---|----------------|-----------|-------------\n";
+        const int from = m_levels.empty() ? m_users : std::max(0, m_levels.front().threshold - 1);
+        for (int k = from; k <= m_users; ++k) {
+            Stats::MeanCI split = column(m_split, k);
+            std::cout << std::setw(2) << k << " | " << std::scientific << std::setprecision(4)
+                      << std::setw(14) << split.mean << " | " << std::setprecision(2) << std::setw(9)
+                      << split.halfWidth << " | " << std::setprecision(4) << column(m_crude, k).mean << "\n";
+        }
+        std::cout << "============================\n";
+        std::cout.unsetf(std::ios::floatfield);
+    }
+};
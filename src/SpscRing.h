@@ -0,0 +1,68 @@
+// === SpscRing.h ===
+#pragma once
+#include <atomic>
+#include <vector>
+#include <cstddef>
+#include <stdexcept>
+
+// Ограниченная кольцевая очередь «один писатель — один читатель» без блокировок.
+// Ёмкость округляется вверх до степени двойки; индексы растут монотонно,
+// позиция в буфере — index & mask. Писатель владеет m_tail, читатель — m_head;
+// каждый кэширует чужой индекс, чтобы не читать общую строку кэша на
+// каждой операции.
+template <class T>
+class SpscRing {
+    static constexpr size_t kCacheLine = 64;
+
+    std::vector<T> m_buffer;
+    size_t m_mask;
+
+    alignas(kCacheLine) std::atomic<size_t> m_head{0};  // следующий к чтению
+    size_t m_cachedTail = 0;                            // копия m_tail у читателя
+
+    alignas(kCacheLine) std::atomic<size_t> m_tail{0};  // следующий к записи
+    size_t m_cachedHead = 0;                            // копия m_head у писателя
+
+    static size_t roundUpPow2(size_t n) {
+        size_t p = 1;
+        while (p < n) p <<= 1;
+        return p;
+    }
+
+public:
+    explicit SpscRing(size_t capacity)
+        : m_buffer(roundUpPow2(capacity)), m_mask(m_buffer.size() - 1) {
+        if (capacity == 0) throw std::invalid_argument("SpscRing capacity must be positive");
+    }
+
+    size_t capacity() const { return m_buffer.size(); }
+
+    // Только писатель. false — очередь полна
+    bool tryPush(const T& value) {
+        const size_t tail = m_tail.load(std::memory_order_relaxed);
+        if (tail - m_cachedHead == m_buffer.size()) {
+            m_cachedHead = m_head.load(std::memory_order_acquire);
+            if (tail - m_cachedHead == m_buffer.size()) return false;
+        }
+        m_buffer[tail & m_mask] = value;
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Только читатель. false — очередь пуста
+    bool tryPop(T& value) {
+        const size_t head = m_head.load(std::memory_order_relaxed);
+        if (head == m_cachedTail) {
+            m_cachedTail = m_tail.load(std::memory_order_acquire);
+            if (head == m_cachedTail) return false;
+        }
+        value = m_buffer[head & m_mask];
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Приблизительная глубина со стороны писателя
+    size_t sizeFromProducer() const {
+        return m_tail.load(std::memory_order_relaxed) - m_head.load(std::memory_order_acquire);
+    }
+};
@@ -0,0 +1,140 @@
+// === Statistics.h ===
+#pragma once
+#include <vector>
+#include <cmath>
+#include <cstddef>
+#include <utility>
+
+namespace Stats {
+
+// Квантиль t-распределения Стьюдента уровня 0.975 (двусторонний 95% ДИ)
+inline double studentT975(int df) {
+    static const double table[] = {
+        12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+        2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+        2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042
+    };
+    if (df <= 0) return INFINITY;
+    if (df <= 30) return table[df - 1];
+    // Разложение Корниша–Фишера вокруг нормального квантиля
+    const double z = 1.959964;
+    double n = static_cast<double>(df);
+    return z + (z * z * z + z) / (4.0 * n)
+             + (5.0 * std::pow(z, 5) + 16.0 * z * z * z + 3.0 * z) / (96.0 * n * n);
+}
+
+// Среднее и полуширина 95% доверительного интервала
+struct MeanCI {
+    double mean = 0.0;
+    double halfWidth = 0.0;
+    double variance = 0.0;  // выборочная дисперсия
+    size_t count = 0;
+
+    double relativeHalfWidth() const {
+        return mean != 0.0 ? halfWidth / std::abs(mean) : INFINITY;
+    }
+};
+
+// Оценка по независимым наблюдениям; порядок суммирования фиксирован,
+// поэтому результат не зависит от того, как наблюдения были получены
+inline MeanCI meanCI(const std::vector<double>& values) {
+    MeanCI ci;
+    ci.count = values.size();
+    if (values.empty()) return ci;
+
+    // Welford: устойчивое накопление среднего и дисперсии
+    double mean = 0.0, m2 = 0.0;
+    for (size_t i = 0; i < values.size(); ++i) {
+        double delta = values[i] - mean;
+        mean += delta / static_cast<double>(i + 1);
+        m2 += delta * (values[i] - mean);
+    }
+    ci.mean = mean;
+    if (values.size() > 1) {
+        ci.variance = m2 / static_cast<double>(values.size() - 1);
+        ci.halfWidth = studentT975(static_cast<int>(values.size()) - 1)
+                     * std::sqrt(ci.variance / static_cast<double>(values.size()));
+    } else {
+        ci.halfWidth = INFINITY;
+    }
+    return ci;
+}
+
+// Решение a·x = b методом Гаусса с выбором главного элемента (малые
+// системы); false, если матрица вырождена. Результат — в b
+inline bool solveLinear(std::vector<std::vector<double>> a, std::vector<double>& b) {
+    const size_t n = b.size();
+    for (size_t col = 0; col < n; ++col) {
+        size_t pivot = col;
+        for (size_t row = col + 1; row < n; ++row)
+            if (std::abs(a[row][col]) > std::abs(a[pivot][col])) pivot = row;
+        if (!(std::abs(a[pivot][col]) > 1e-300)) return false;
+        std::swap(a[col], a[pivot]);
+        std::swap(b[col], b[pivot]);
+        for (size_t row = col + 1; row < n; ++row) {
+            double factor = a[row][col] / a[col][col];
+            for (size_t j = col; j < n; ++j) a[row][j] -= factor * a[col][j];
+            b[row] -= factor * b[col];
+        }
+    }
+    for (size_t col = n; col-- > 0;) {
+        for (size_t j = col + 1; j < n; ++j) b[col] -= a[col][j] * b[j];
+        b[col] /= a[col][col];
+    }
+    return true;
+}
+
+// Оценка среднего с управляющими переменными: controls[j][i] — величина
+// с известным нулевым средним в наблюдении i (например, отклонение
+// среднего выданных случайных величин от Distribution::mean()).
+// Коэффициенты β — МНК-регрессия values на controls, оценка ȳ − β·c̄,
+// дисперсия — по остаткам с n − 1 − k степенями свободы (Lavenberg,
+// Welch 1981). variance — эквивалентная дисперсия одного наблюдения.
+// При вырожденных controls или n ≤ k + 1 — обычное среднее
+inline MeanCI controlVariateCI(const std::vector<double>& values, const std::vector<std::vector<double>>& controls) {
+    const size_t n = values.size();
+    const size_t k = controls.size();
+    if (k == 0 || n <= k + 1) return meanCI(values);
+
+    double meanY = 0.0;
+    for (double y : values) meanY += y;
+    meanY /= static_cast<double>(n);
+    std::vector<double> meanC(k, 0.0);
+    for (size_t j = 0; j < k; ++j) {
+        for (double c : controls[j]) meanC[j] += c;
+        meanC[j] /= static_cast<double>(n);
+    }
+
+    std::vector<std::vector<double>> scatter(k, std::vector<double>(k, 0.0));
+    std::vector<double> beta(k, 0.0);
+    for (size_t i = 0; i < n; ++i) {
+        for (size_t j = 0; j < k; ++j) {
+            double dj = controls[j][i] - meanC[j];
+            beta[j] += dj * (values[i] - meanY);
+            for (size_t l = 0; l < k; ++l) scatter[j][l] += dj * (controls[l][i] - meanC[l]);
+        }
+    }
+    std::vector<double> leverage = meanC;
+    if (!solveLinear(scatter, beta) || !solveLinear(scatter, leverage)) return meanCI(values);
+
+    MeanCI ci;
+    ci.count = n;
+    ci.mean = meanY;
+    for (size_t j = 0; j < k; ++j) ci.mean -= beta[j] * meanC[j];
+
+    double sse = 0.0;
+    for (size_t i = 0; i < n; ++i) {
+        double residual = values[i] - meanY;
+        for (size_t j = 0; j < k; ++j) residual -= beta[j] * (controls[j][i] - meanC[j]);
+        sse += residual * residual;
+    }
+    const int df = static_cast<int>(n - 1 - k);
+    double factor = 1.0 / static_cast<double>(n);
+    for (size_t j = 0; j < k; ++j) factor += meanC[j] * leverage[j];
+    double estimatorVariance = sse / df * factor;
+    ci.variance = estimatorVariance * static_cast<double>(n);
+    ci.halfWidth = studentT975(df) * std::sqrt(estimatorVariance);
+    return ci;
+}
+
+} // namespace Stats
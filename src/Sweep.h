@@ -0,0 +1,257 @@
+// === Sweep.h ===
+#pragma once
+#include "Simulator.h"
+#include "CliUtils.h"
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <sstream>
+#include <iomanip>
+#include <ostream>
+#include <mutex>
+#include <cmath>
+#include <cstdlib>
+#include <cstdio>
+#include <stdexcept>
+
+namespace Sweep {
+
+// Ось перебора: имя параметра CLI (без "--") и его значения
+struct Axis {
+    std::string name;
+    std::vector<std::string> values;
+};
+
+// Точка сетки: значения всех осей
+using Point = std::vector<std::pair<std::string, std::string>>;
+
+// Разбивает по запятым верхнего уровня (запятые внутри [...] не считаются)
+inline std::vector<std::string> splitTopLevel(const std::string& str) {
+    std::vector<std::string> tokens;
+    std::string current;
+    int depth = 0;
+    for (char c : str) {
+        if (c == '[') ++depth;
+        if (c == ']') --depth;
+        if (c == ',' && depth == 0) {
+            if (!current.empty()) tokens.push_back(current);
+            current.clear();
+        } else {
+            current += c;
+        }
+    }
+    if (depth != 0) throw std::invalid_argument("Unbalanced brackets in sweep spec: " + str);
+    if (!current.empty()) tokens.push_back(current);
+    return tokens;
+}
+
+inline bool isNumber(const std::string& s) {
+    if (s.empty()) return false;
+    char* end = nullptr;
+    std::strtod(s.c_str(), &end);
+    return end == s.c_str() + s.size();
+}
+
+inline std::string formatNumber(double value) {
+    std::ostringstream oss;
+    oss << std::setprecision(10) << value;
+    return oss.str();
+}
+
+// Значения одной оси:
+//   a:b:step        — числовой диапазон включительно (users=10:200:10)
+//   [x,y,z]         — список (base-rate=[0.5,1,2])
+//   prefix[x,y,z]   — список с общим префиксом (degradation=hyp:[5,10,20])
+//   value           — одно значение
+inline std::vector<std::string> parseValues(const std::string& spec) {
+    std::vector<std::string> values;
+
+    auto open = spec.find('[');
+    if (open != std::string::npos) {
+        if (spec.back() != ']') throw std::invalid_argument("Sweep list must end with ']': " + spec);
+        std::string prefix = spec.substr(0, open);
+        for (const auto& item : Cli::split(spec.substr(open + 1, spec.size() - open - 2), ',')) {
+            values.push_back(prefix + item);
+        }
+        return values;
+    }
+
+    auto parts = Cli::split(spec, ':');
+    if (parts.size() == 3 && isNumber(parts[0]) && isNumber(parts[1]) && isNumber(parts[2])) {
+        double from = std::stod(parts[0]), to = std::stod(parts[1]), step = std::stod(parts[2]);
+        if (step <= 0 || to < from) throw std::invalid_argument("Invalid sweep range: " + spec);
+        for (size_t i = 0; ; ++i) {
+            double value = from + static_cast<double>(i) * step;
+            if (value > to + 1e-9 * step) break;
+            values.push_back(formatNumber(value));
+        }
+        return values;
+    }
+
+    values.push_back(spec);
+    return values;
+}
+
+inline std::vector<Axis> parseSpec(const std::string& spec) {
+    std::vector<Axis> axes;
+    for (const auto& token : splitTopLevel(spec)) {
+        auto eq = token.find('=');
+        if (eq == std::string::npos || eq == 0)
+            throw std::invalid_argument("Sweep axis must be name=values: " + token);
+        Axis axis{token.substr(0, eq), parseValues(token.substr(eq + 1))};
+        if (axis.values.empty()) throw std::invalid_argument("Empty sweep axis: " + token);
+        axes.push_back(std::move(axis));
+    }
+    if (axes.empty()) throw std::invalid_argument("Empty sweep spec");
+    return axes;
+}
+
+// Декартово произведение осей; последняя ось меняется быстрее всего
+inline std::vector<Point> expand(const std::vector<Axis>& axes) {
+    std::vector<Point> points(1);
+    for (const auto& axis : axes) {
+        std::vector<Point> next;
+        next.reserve(points.size() * axis.values.size());
+        for (const auto& point : points) {
+            for (const auto& value : axis.values) {
+                Point extended = point;
+                extended.emplace_back(axis.name, value);
+                next.push_back(std::move(extended));
+            }
+        }
+        points = std::move(next);
+    }
+    return points;
+}
+
+enum class Format { Csv, Json };
+
+// Потоковый вывод строк результатов; безопасен для вызова из рабочих потоков.
+// Строки идут в порядке завершения, номер точки — в поле point.
+class RowWriter {
+    std::ostream& m_out;
+    Format m_format;
+    std::vector<std::string> m_axisNames;
+    std::mutex m_mutex;
+
+    // Число в грамматике JSON (без кавычек годится и для CSV):
+    // -?(0|[1-9]d*)(.d+)?([eE][+-]?d+)?
+    static bool isNumber(const std::string& s) {
+        size_t i = 0;
+        auto digits = [&] {
+            size_t start = i;
+            while (i < s.size() && s[i] >= '0' && s[i] <= '9') ++i;
+            return i - start;
+        };
+        if (i < s.size() && s[i] == '-') ++i;
+        size_t start = i;
+        if (digits() == 0 || (s[start] == '0' && i - start > 1)) return false;
+        if (i < s.size() && s[i] == '.') {
+            ++i;
+            if (digits() == 0) return false;
+        }
+        if (i < s.size() && (s[i] == 'e' || s[i] == 'E')) {
+            ++i;
+            if (i < s.size() && (s[i] == '+' || s[i] == '-')) ++i;
+            if (digits() == 0) return false;
+        }
+        return i == s.size();
+    }
+
+    // Поле CSV (RFC 4180): кавычки внутри удваиваются
+    static std::string csvField(const std::string& s) {
+        if (isNumber(s)) return s;
+        std::string out = "\"";
+        for (char c : s) out += c == '"' ? std::string("\"\"") : std::string(1, c);
+        return out + "\"";
+    }
+
+    // Строка JSON с экранированием кавычек, обратной косой черты и
+    // управляющих символов
+    static std::string jsonString(const std::string& s) {
+        std::string out = "\"";
+        for (unsigned char c : s) {
+            if (c == '"' || c == '\\') {
+                out += '\\';
+                out += static_cast<char>(c);
+            } else if (c < 0x20) {
+                char buf[8];
+                std::snprintf(buf, sizeof(buf), "\\u%04x", c);
+                out += buf;
+            } else {
+                out += static_cast<char>(c);
+            }
+        }
+        return out + "\"";
+    }
+
+    static std::string jsonValue(const std::string& s) {
+        return isNumber(s) ? s : jsonString(s);
+    }
+
+public:
+    RowWriter(std::ostream& out, Format format, const std::vector<Axis>& axes)
+        : m_out(out), m_format(format) {
+        for (const auto& axis : axes) m_axisNames.push_back(axis.name);
+    }
+
+    void writeHeader() {
+        if (m_format != Format::Csv) return;
+        m_out << "point";
+        for (const auto& name : m_axisNames) m_out << "," << name;
+        m_out << ",utilization,avg_active_time,avg_passive_time,avg_task_count,"
+              << "max_concurrent,events,latency_mean,latency_p50,latency_p95,latency_p99,"
+              << "latency_p999,pk\n";
+        m_out.flush();
+    }
+
+    void write(size_t index, const Point& point, const SimulationStats& stats, int users) {
+        std::ostringstream row;
+        row << std::setprecision(10);
+        auto pk = stats.getProbabilityDistribution();
+        const auto& latency = stats.completionTime;
+
+        if (m_format == Format::Csv) {
+            row << index;
+            for (const auto& kv : point) row << "," << csvField(kv.second);
+            row << "," << stats.getNodeUtilization(users)
+                << "," << stats.getAvgActiveTime()
+                << "," << stats.getAvgPassiveTime()
+                << "," << stats.getAvgTaskCount()
+                << "," << stats.maxConcurrentUsers
+                << "," << stats.totalEventsProcessed
+                << "," << latency.mean()
+                << "," << latency.quantile(0.50)
+                << "," << latency.quantile(0.95)
+                << "," << latency.quantile(0.99)
+                << "," << latency.quantile(0.999)
+                << ",\"";
+            for (size_t k = 0; k < pk.size(); ++k) row << (k ? ";" : "") << pk[k];
+            row << "\"\n";
+        } else {
+            row << "{\"point\":" << index;
+            for (const auto& kv : point) row << "," << jsonString(kv.first) << ":" << jsonValue(kv.second);
+            row << ",\"utilization\":" << stats.getNodeUtilization(users)
+                << ",\"avg_active_time\":" << stats.getAvgActiveTime()
+                << ",\"avg_passive_time\":" << stats.getAvgPassiveTime()
+                << ",\"avg_task_count\":" << stats.getAvgTaskCount()
+                << ",\"max_concurrent\":" << stats.maxConcurrentUsers
+                << ",\"events\":" << stats.totalEventsProcessed
+                << ",\"latency\":{\"mean\":" << latency.mean()
+                << ",\"p50\":" << latency.quantile(0.50)
+                << ",\"p95\":" << latency.quantile(0.95)
+                << ",\"p99\":" << latency.quantile(0.99)
+                << ",\"p999\":" << latency.quantile(0.999) << "}"
+                << ",\"pk\":[";
+            for (size_t k = 0; k < pk.size(); ++k) row << (k ? "," : "") << pk[k];
+            row << "]}\n";
+        }
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_out << row.str();
+        m_out.flush();
+    }
+};
+
+} // namespace Sweep
@@ -0,0 +1,182 @@
+// === ThreadPool.h ===
+#pragma once
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <exception>
+#include <functional>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+namespace Parallel {
+
+// Число потоков по умолчанию: все доступные ядра
+inline unsigned defaultThreads() {
+    unsigned n = std::thread::hardware_concurrency();
+    return n > 0 ? n : 1;
+}
+
+// Выполняет task(i) для i = 0..count-1 на threads потоках с перехватом работы
+// (work stealing). Задачи раздаются по кругу: каждый поток берёт свои с начала
+// очереди, а опустевший поток забирает чужие с конца. Поэтому задачи,
+// упорядоченные по убыванию стоимости, стартуют первыми.
+// Первое исключение из task пробрасывается вызывающему после join.
+inline void forEach(size_t count, unsigned threads, const std::function<void(size_t)>& task) {
+    if (count == 0) return;
+    threads = std::max(1u, std::min<unsigned>(threads, static_cast<unsigned>(count)));
+    if (threads == 1) {
+        for (size_t i = 0; i < count; ++i) task(i);
+        return;
+    }
+
+    struct WorkerQueue {
+        std::mutex mutex;
+        std::deque<size_t> tasks;
+    };
+    std::vector<WorkerQueue> queues(threads);
+    for (size_t i = 0; i < count; ++i) queues[i % threads].tasks.push_back(i);
+
+    std::atomic<bool> failed{false};
+    std::exception_ptr error;
+    std::mutex errorMutex;
+
+    auto takeOwn = [&](unsigned w, size_t& out) {
+        std::lock_guard<std::mutex> lock(queues[w].mutex);
+        if (queues[w].tasks.empty()) return false;
+        out = queues[w].tasks.front();
+        queues[w].tasks.pop_front();
+        return true;
+    };
+    auto steal = [&](unsigned w, size_t& out) {
+        for (unsigned k = 1; k < threads; ++k) {
+            unsigned victim = (w + k) % threads;
+            std::lock_guard<std::mutex> lock(queues[victim].mutex);
+            if (queues[victim].tasks.empty()) continue;
+            out = queues[victim].tasks.back();
+            queues[victim].tasks.pop_back();
+            return true;
+        }
+        return false;
+    };
+
+    auto worker = [&](unsigned w) {
+        size_t index = 0;
+        while (!failed.load(std::memory_order_relaxed)
+               && (takeOwn(w, index) || steal(w, index))) {
+            try {
+                task(index);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(errorMutex);
+                if (!error) error = std::current_exception();
+                failed.store(true, std::memory_order_relaxed);
+            }
+        }
+    };
+
+    std::vector<std::thread> pool;
+    pool.reserve(threads);
+    for (unsigned w = 0; w < threads; ++w) pool.emplace_back(worker, w);
+    for (auto& t : pool) t.join();
+
+    if (error) std::rethrow_exception(error);
+}
+
+// Постоянная группа потоков для частых коротких forEach (окна синхронизации
+// кластера): потоки создаются один раз и между вызовами ждут на условной
+// переменной. Индексы раздаются атомарным счётчиком, вызывающий поток
+// работает наравне с остальными. Первое исключение пробрасывается после
+// того, как все потоки закончили текущий вызов.
+class Team {
+    std::vector<std::thread> m_workers;
+    std::mutex m_mutex;
+    std::condition_variable m_start;
+    std::condition_variable m_done;
+    const std::function<void(size_t)>* m_task = nullptr;
+    size_t m_count = 0;
+    std::atomic<size_t> m_next{0};
+    size_t m_busy = 0;
+    uint64_t m_generation = 0;
+    bool m_stop = false;
+    std::exception_ptr m_error;
+
+    void runTasks(const std::function<void(size_t)>& task, size_t count) {
+        for (size_t i; (i = m_next.fetch_add(1, std::memory_order_relaxed)) < count;) {
+            try {
+                task(i);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if (!m_error) m_error = std::current_exception();
+            }
+        }
+    }
+
+    void work() {
+        uint64_t seen = 0;
+        for (;;) {
+            const std::function<void(size_t)>* task;
+            size_t count;
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_start.wait(lock, [&] { return m_stop || m_generation != seen; });
+                if (m_stop) return;
+                seen = m_generation;
+                task = m_task;
+                count = m_count;
+            }
+            runTasks(*task, count);
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (--m_busy == 0) m_done.notify_one();
+        }
+    }
+
+public:
+    explicit Team(unsigned threads) {
+        for (unsigned w = 1; w < threads; ++w) m_workers.emplace_back([this] { work(); });
+    }
+
+    ~Team() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_start.notify_all();
+        for (auto& t : m_workers) t.join();
+    }
+
+    Team(const Team&) = delete;
+    Team& operator=(const Team&) = delete;
+
+    unsigned size() const { return static_cast<unsigned>(m_workers.size()) + 1; }
+
+    void forEach(size_t count, const std::function<void(size_t)>& task) {
+        if (count == 0) return;
+        if (m_workers.empty() || count == 1) {
+            for (size_t i = 0; i < count; ++i) task(i);
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_task = &task;
+            m_count = count;
+            m_next.store(0, std::memory_order_relaxed);
+            m_busy = m_workers.size();
+            ++m_generation;
+        }
+        m_start.notify_all();
+        runTasks(task, count);
+
+        std::exception_ptr error;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_done.wait(lock, [&] { return m_busy == 0; });
+            std::swap(error, m_error);
+        }
+        if (error) std::rethrow_exception(error);
+    }
+};
+
+} // namespace Parallel
@@ -5,6 +5,18 @@
 #include "CliUtils.h" 
 #include "CsvUtils.h" 
 #include "CsvStatisticsCollector.h"
+#include "AsyncListener.h"
+#include "BinarySnapshotWriter.h"
+#include "Degradation.h"
+#include "Replications.h"
+#include "ThreadPool.h"
+#include "Sweep.h"
+#include "SequentialStopping.h"
+#include "Analytic.h"
+#include "Cluster.h"
+#include "Comparison.h"
+#include "Splitting.h"
+#include "RoutingPolicies.h"
 
 #include <iostream>
 #include <iomanip>
@@ -13,18 +25,58 @@
 #include <optional>
 #include <functional>
 #include <cmath>
+#include <numeric>
+#include <algorithm>
+#include <chrono>
 
 // === Структура аргументов командной строки ===
 struct Args {
     int users = 10;                    // число пользователей
     double simTime = 1000.0;           // время симуляции
-    int seed = 42;                     // seed для ГСЧ
+    uint64_t seed = 42;                // seed для ГСЧ
+    std::string rngEngine = "xoshiro"; // базовый генератор: xoshiro | philox
     std::string workloadDist = "exp:1.0";  // распределение ОБЪЁМА работы (было --active)
     std::string serviceTimeDist = "exp:1.0";
     std::string passiveDist = "exp:0.5";   // распределение времени простоя
     double baseRate = 1.0;             // базовая скорость обслуживания μ₀
     std::string degradationSpec = "hyp:10.0"; // спецификация функции деградации
+    std::string engine = "rescale";    // режим учёта изменения скорости: rescale | vtime | lumped
+    bool perUserStats = true;          // учёт времени и задач по каждому пользователю
+    std::string quantiles = "hdr";     // оценка квантилей времени отклика: hdr | tdigest
+    bool genericEngine = false;        // не использовать специализированные симуляторы
+    int replications = 1;              // число независимых прогонов
+    std::string compareSpec;           // сценарий B для парного сравнения: ось=значение
+    bool commonRandom = false;         // свои подпотоки ГСЧ у каждого пользователя
+    bool antithetic = false;           // антитетические пары прогонов в --compare
+    bool controlVariates = false;      // управляющие переменные в --compare
+    int restartFrom = 0;               // нижний порог расщепления RESTART (0 — выключено)
+    int restartFactor = 0;             // повторных испытаний на пороге (0 — по интенсивностям)
+    int nodes = 1;                     // узлов в кластере (1 — одиночный узел)
+    std::string routing = "jsq";       // маршрутизация по узлам: random | round-robin | jsq | least-degraded
+    double dispatchDelay = 0.01;       // задержка доставки задачи на узел (lookahead)
+    double syncWindow = 0.0;           // окно синхронизации узлов (0 — равно задержке)
+    unsigned threads = Parallel::defaultThreads(); // потоки для независимых прогонов
+    double precision = 0.0;            // цель отн. полуширины ДИ (0 — фиксированное время)
+    double precisionPkMin = 0.01;      // отслеживаемые P(k) — не меньше этого порога
+    double monitorInterval = 1.0;      // период тиков мониторинга, сек
+    double monitorWindow = 0.0;        // окно агрегации снимков (0 — точечные снимки)
+    std::string snapshotFormat = "csv"; // формат снимков мониторинга: csv | bin | none
+    std::string snapshotFile;          // файл снимков (по умолчанию simulation_data.<формат>)
+    std::string asyncSnapshots;        // фоновая запись снимков: "" (синхронно) | block | drop
+    size_t snapshotQueue = 4096;       // ёмкость очереди фоновой записи
+    std::string checkpointFile;        // куда писать контрольную точку
+    double checkpointEvery = 0.0;      // период контрольных точек (0 — только в конце)
+    std::string resumeFile;            // продолжить прогон с контрольной точки
+    std::string sweepSpec;             // сетка параметров для --sweep
+    std::string sweepFormat = "csv";   // формат строк перебора: csv | json
+    std::string sweepOutput;           // файл строк перебора (по умолчанию stdout)
     std::string csvOutput;             // файл для вывода P(k)
+    bool analytic = false;             // решить цепь рождения–гибели вместо симуляции
+    bool validate = false;             // сверить симуляцию с аналитическим решением
+    int analyticPhases = 8;            // предел числа фаз при подборе фазовых распределений
+    int analyticClasses = 1;           // классы объёма работы (1 — среднее поле R_k = k·E[W])
+    bool profile = false;              // счётчики горячего пути (сборка с SIMULATOR_PROFILE)
+    std::string profileJson;           // экспорт счётчиков в JSON
     bool help = false;                 // флаг помощи
 };
 
@@ -44,7 +96,10 @@ Args parseArgs(int argc, char* argv[]) {
             args.simTime = std::stod(argv[++i]);
             
         } else if (arg == "--seed" && i+1 < argc) {
-            args.seed = std::stoi(argv[++i]);
+            args.seed = std::stoull(argv[++i]);
+            
+        } else if (arg == "--rng" && i+1 < argc) {
+            args.rngEngine = argv[++i];
             
         } else if (arg == "--workload" && i+1 < argc) {  // ← было --active
             args.workloadDist = argv[++i];
@@ -61,6 +116,114 @@ Args parseArgs(int argc, char* argv[]) {
         } else if (arg == "--degradation" && i+1 < argc) {  // ← новое
             args.degradationSpec = argv[++i];
             
+        } else if (arg == "--engine" && i+1 < argc) {
+            args.engine = argv[++i];
+            
+        } else if (arg == "--replications" && i+1 < argc) {
+            args.replications = std::stoi(argv[++i]);
+            
+        } else if (arg == "--compare" && i+1 < argc) {
+            args.compareSpec = argv[++i];
+            
+        } else if (arg == "--crn") {
+            args.commonRandom = true;
+            
+        } else if (arg == "--antithetic") {
+            args.antithetic = true;
+            
+        } else if (arg == "--control-variates") {
+            args.controlVariates = true;
+            
+        } else if (arg == "--restart" && i+1 < argc) {
+            args.restartFrom = std::stoi(argv[++i]);
+            
+        } else if (arg == "--restart-factor" && i+1 < argc) {
+            args.restartFactor = std::stoi(argv[++i]);
+            
+        } else if (arg == "--nodes" && i+1 < argc) {
+            args.nodes = std::stoi(argv[++i]);
+            
+        } else if (arg == "--routing" && i+1 < argc) {
+            args.routing = argv[++i];
+            
+        } else if (arg == "--dispatch-delay" && i+1 < argc) {
+            args.dispatchDelay = std::stod(argv[++i]);
+            
+        } else if (arg == "--sync-window" && i+1 < argc) {
+            args.syncWindow = std::stod(argv[++i]);
+            
+        } else if (arg == "--threads" && i+1 < argc) {
+            args.threads = static_cast<unsigned>(std::stoul(argv[++i]));
+            
+        } else if (arg == "--quantiles" && i+1 < argc) {
+            args.quantiles = argv[++i];
+            
+        } else if (arg == "--no-per-user-stats") {
+            args.perUserStats = false;
+        } else if (arg == "--generic") {
+            args.genericEngine = true;
+            
+        } else if (arg == "--precision" && i+1 < argc) {
+            args.precision = std::stod(argv[++i]);
+            
+        } else if (arg == "--precision-pk-min" && i+1 < argc) {
+            args.precisionPkMin = std::stod(argv[++i]);
+            
+        } else if (arg == "--monitor-interval" && i+1 < argc) {
+            args.monitorInterval = std::stod(argv[++i]);
+            
+        } else if (arg == "--monitor-window" && i+1 < argc) {
+            args.monitorWindow = std::stod(argv[++i]);
+            
+        } else if (arg == "--snapshot-format" && i+1 < argc) {
+            args.snapshotFormat = argv[++i];
+            
+        } else if (arg == "--snapshot-file" && i+1 < argc) {
+            args.snapshotFile = argv[++i];
+            
+        } else if (arg == "--async-snapshots" && i+1 < argc) {
+            args.asyncSnapshots = argv[++i];
+            
+        } else if (arg == "--snapshot-queue" && i+1 < argc) {
+            args.snapshotQueue = std::stoull(argv[++i]);
+            
+        } else if (arg == "--analytic") {
+            args.analytic = true;
+            
+        } else if (arg == "--validate") {
+            args.validate = true;
+            
+        } else if (arg == "--analytic-phases" && i+1 < argc) {
+            args.analyticPhases = std::stoi(argv[++i]);
+            
+        } else if (arg == "--analytic-classes" && i+1 < argc) {
+            args.analyticClasses = std::stoi(argv[++i]);
+            
+        } else if (arg == "--profile") {
+            args.profile = true;
+            
+        } else if (arg == "--profile-json" && i+1 < argc) {
+            args.profile = true;
+            args.profileJson = argv[++i];
+            
+        } else if (arg == "--checkpoint" && i+1 < argc) {
+            args.checkpointFile = argv[++i];
+            
+        } else if (arg == "--checkpoint-every" && i+1 < argc) {
+            args.checkpointEvery = std::stod(argv[++i]);
+            
+        } else if (arg == "--resume" && i+1 < argc) {
+            args.resumeFile = argv[++i];
+            
+        } else if (arg == "--sweep" && i+1 < argc) {
+            args.sweepSpec = argv[++i];
+            
+        } else if (arg == "--sweep-format" && i+1 < argc) {
+            args.sweepFormat = argv[++i];
+            
+        } else if (arg == "--sweep-output" && i+1 < argc) {
+            args.sweepOutput = argv[++i];
+            
         } else if (arg == "--csv" && i+1 < argc) {
             args.csvOutput = argv[++i];
         }
@@ -89,12 +252,122 @@ Options:
   --users N           Number of users (closed system)
   --time T            Simulation time in seconds
   --seed S            Random seed for reproducibility
+  --rng ENGINE        Random engine: xoshiro (xoshiro256++, default) or philox
+                      (counter-based Philox4x32-10)
   --workload SPEC     Workload distribution per task (volume, not time!)
   --service-time SPEC Service time distribution 
   --passive SPEC      Passive phase (idle time) distribution
   --base-rate MU0     Base service rate (work units per second)
   --degradation FN    Degradation function specification
+  --engine MODE       Rate-change engine: rescale (O(N) per event, default)
+                      vtime (virtual service clock, O(log N) per event) or
+                      lumped (idle users kept as a count, one aggregate event
+                      stream, O(1) per event; exponential --passive and
+                      --service-time only)
+  --no-per-user-stats Do not track time and tasks per user; averages in the
+                      summary come from totals over all users. Saves ~36 bytes
+                      per user; with --engine lumped the activating user is
+                      not chosen and no per-user memory is allocated at all
+  --quantiles METHOD  Completion-time quantile estimator: hdr (log-linear
+                      histogram, default) or tdigest
+  --generic           Always use the generic (virtual) simulator, even when a
+                      specialized one exists (exp/exp/exp + any degradation)
+  --replications R    Run R independent replications and report 95% CIs
+  --threads T         Worker threads for replications, sweep points, cluster
+                      nodes and --analytic (default: all cores)
+  --compare AXIS=VAL  Paired comparison of the current options (A) with the same
+                      options where one sweep axis is changed (B), e.g.
+                      degradation=hyp:20 or base-rate=1.2; run --replications
+                      pairs (at least 2) and report B - A with its 95% CI, the
+                      CI of independent runs and the replication saving factor
+  --crn               Common random numbers: every user draws passive time,
+                      workload and service time from its own substreams
+                      (exponentials by inversion), so paired scenarios see
+                      the same values whatever the event order; ~360 bytes
+                      per user; rescale and vtime engines only
+  --antithetic        With --compare --crn: replications 2i and 2i+1 use one
+                      stream and its antithetic copy (U -> 1-U, Z -> -Z);
+                      needs an even --replications >= 4
+  --control-variates  With --compare: regress the difference on the deviation
+                      of the drawn passive time and workload means from their
+                      known means (Distribution::mean); the CI then has
+                      n - 3 degrees of freedom, so it needs at least 10 units
+                      (replications, or pairs with --antithetic)
+  --restart K         Estimate the saturation tail P(k = N), P(k >= N-1) by
+                      RESTART splitting on the active-user count with a
+                      threshold at every k = K..N: a trajectory reaching a
+                      threshold is copied into retrials that die when they
+                      fall below it. Runs --replications (at least 2) splitting
+                      and crude runs of --time each and reports both estimates
+                      with relative errors and the speedup at equal error.
+                      Use --engine lumped (exponential --passive and
+                      --service-time): retrials then copy O(k) state and
+                      redraw the next event; with other engines they copy
+                      O(N) state and share the already drawn event times
+  --restart-factor R  Retrials per threshold crossing (default: the ratio
+                      pi(k >= L_i) / pi(k >= L_i+1) of the mean-field
+                      birth-death steady state, so that the product of the
+                      factors is about 1 / P(tail); capped at 100)
+  --nodes M           Simulate a cluster of M nodes sharing --users users: idle
+                      users live in a dispatcher that routes each task to a
+                      node; nodes run in parallel on --threads threads and
+                      the result does not depend on the thread count. Use
+                      --engine vtime: with rescale every node event walks
+                      all users of the cluster
+  --routing POLICY    Cluster routing: random, round-robin, jsq (fewest tasks,
+                      default) or least-degraded (highest rate after arrival)
+  --dispatch-delay D  Delivery delay of a task to its node, seconds (default
+                      0.01); it is the lookahead of the parallel simulation
+  --sync-window W     Node synchronization window, 0 < W <= D (default D);
+                      smaller windows only add barriers
+  --precision EPS     Stop as soon as the relative 95% CI half-width of the
+                      utilization and of every tracked P(k) is below EPS
+                      (batch means, MSER warm-up truncation); --time becomes
+                      the upper bound
+  --precision-pk-min P  Track only P(k) >= P for --precision (default 0.01)
+  --monitor-interval T  Seconds between monitoring snapshots (default 1.0); also
+                      the observation step of --precision
+  --monitor-window W  Instead of point snapshots, write one row per window of W
+                      seconds: time-weighted mean/min/max of active users and
+                      effective rate (csv snapshots only)
+  --snapshot-format F Monitoring snapshot output: csv (default), bin (columnar
+                      binary, convert with snapshot2csv) or none
+  --snapshot-file FILE  Snapshot file (default simulation_data.csv / .bin)
+  --async-snapshots P Write monitoring snapshots on a background thread through
+                      a lock-free queue; P is the overflow policy: block (wait
+                      for the writer) or drop (discard and count)
+  --snapshot-queue N  Capacity of the background snapshot queue (default 4096)
+  --checkpoint FILE   Save the full simulator state to FILE at the end of the run
+  --checkpoint-every T  Also save it every T simulated seconds (needs --checkpoint)
+  --resume FILE       Continue a run from a checkpoint up to --time (absolute);
+                      all model options must match the original run (checked:
+                      users, engine, base rate, distributions, degradation,
+                      --quantiles, per-user statistics)
+  --sweep GRID        Run every point of a parameter grid on --threads threads,
+                      e.g. "users=10:200:10,degradation=hyp:[5,10,20]".
+                      Axes: users, time, base-rate, degradation, workload,
+                      service-time, passive. Values: a:b:step, [x,y], prefix[x,y]
+  --sweep-format F    Sweep row format: csv (default) or json (one object per line)
+  --sweep-output FILE Write sweep rows to FILE instead of stdout
   --csv FILE          Save P(k) distribution to CSV (optional)
+  --analytic          Solve the model as a CTMC instead of simulating: a
+                      birth-death chain for exp: passive and service time,
+                      otherwise both are fitted with phase-type distributions
+                      (two moments) and the lumped per-phase chain is solved
+                      with parallel Gauss-Seidel on --threads threads. Exact
+                      for a det: workload and exp:/ph: phases, mean-field
+                      R_k = k*E[W] otherwise. Service time must be exp, gamma,
+                      lognorm or ph
+  --analytic-phases K Maximum phases per fitted distribution (default 8)
+  --analytic-classes L  Track active users in L equiprobable workload classes
+                      instead of the mean-field R_k = k*E[W] (default 1); more
+                      classes approach the exact answer for random workloads
+  --validate          Simulate and report max |dP(k)| against --analytic
+  --profile           Print hot-path counters: per-event-type count and time,
+                      stale-event ratio, queue high-water mark, RNG calls per
+                      distribution, listener time (build with
+                      -DSIMULATOR_PROFILE=ON)
+  --profile-json FILE Also export the counters as JSON (implies --profile)
   --help, -h          Show this help
 
 Examples:
@@ -111,66 +384,414 @@ Examples:
 
   # Детерминированный объём работы + экспоненциальная деградация
   ./simulator --workload "det:2.0" --degradation "exp:0.05" --base-rate 2.0
+
+  # Сравнение двух функций деградации: 20 пар прогонов с общими
+  # случайными числами, антитетикой и управляющими переменными
+  ./simulator --users 20 --time 1e4 --compare degradation=hyp:20 --replications 20 \
+              --crn --antithetic --control-variates
+
+  # Хвост P(k = N) ~ 1e-8 для 20 пользователей: расщепление с порогами k = 12..20
+  ./simulator --users 20 --passive exp:0.3 --workload det:1.0 --engine lumped \
+              --restart 12 --replications 10
+
+  # Кластер из 100 узлов, 5000 пользователей, маршрутизация по деградации
+  ./simulator --nodes 100 --users 5000 --engine vtime --routing least-degraded
 )";
 }
 
-// === Фабрика функций деградации ===
-std::function<double(double)> parseDegradationFn(const std::string& spec) {
-    auto parts = Cli::split(spec, ':');
-    if (parts.empty()) {
-        throw std::invalid_argument("Empty degradation spec");
+// Поток stream генератора, заданного --seed/--rng (поток 0 — основной)
+RandomGenerator createRng(const Args& args, uint64_t stream = 0) {
+    RngEngine engine = args.rngEngine == "philox" ? RngEngine::Philox4x32 : RngEngine::Xoshiro256pp;
+    return RandomGenerator(args.seed, engine).stream(stream);
+}
+
+// Слушатель снимков мониторинга для одиночного прогона; с --async-snapshots
+// вывод уходит в фоновый поток
+std::unique_ptr<ISimulationListener> createSnapshotListener(const Args& args) {
+    if (args.snapshotFormat == "none") return nullptr;
+    
+    std::string file = args.snapshotFile.empty() ? "simulation_data." + args.snapshotFormat : args.snapshotFile;
+    std::unique_ptr<ISimulationListener> listener;
+    if (args.snapshotFormat == "bin") {
+        listener = std::make_unique<BinarySnapshotWriter>(file, args.baseRate);
+    } else {
+        listener = std::make_unique<CsvStatisticsCollector>(file);
+    }
+    if (args.asyncSnapshots.empty()) return listener;
+    
+    OverflowPolicy policy = args.asyncSnapshots == "drop" ? OverflowPolicy::Drop : OverflowPolicy::Block;
+    return std::make_unique<AsyncListener>(std::move(listener), args.snapshotQueue, policy);
+}
+
+// Приводит распределение к конкретному типу T, если оно им является
+template <class T>
+std::unique_ptr<T> downcast(std::unique_ptr<Distribution>& dist) {
+    if (!dynamic_cast<T*>(dist.get())) return nullptr;
+    return std::unique_ptr<T>(static_cast<T*>(dist.release()));
+}
+
+// === Сборка симулятора по аргументам CLI ===
+// Если спецификация совпадает с заранее инстанцированной специализацией
+// (все распределения exp + любое ядро деградации), симулятор —
+// ExponentialSimulator<ядро>; иначе — обобщённый Simulator. visit получает
+// фабрику make(rng) → unique_ptr на симулятор выбранного типа: так можно
+// собрать несколько симуляторов одного типа (узлы кластера).
+template <class Visitor>
+void withSimulatorFactory(const Args& args, Visitor&& visit) {
+    // === Парсинг распределений ===
+    auto workloadCfg = Cli::parseDist(args.workloadDist);
+    auto passiveCfg = Cli::parseDist(args.passiveDist);
+    auto serviceCfg = Cli::parseDist(args.serviceTimeDist);
+    
+    // === Создание функции деградации ===
+    auto degradation = parseDegradation(args.degradationSpec);
+    EngineMode engineMode = args.engine == "vtime" ? EngineMode::VirtualTime
+                          : args.engine == "lumped" ? EngineMode::Lumped : EngineMode::Rescale;
+    QuantileMethod quantileMethod = args.quantiles == "tdigest" ? QuantileMethod::TDigest : QuantileMethod::Hdr;
+    auto configure = [&](auto& sim) {
+        sim.setEngineMode(engineMode);
+        sim.setPerUserStats(args.perUserStats);
+        sim.setQuantileMethod(quantileMethod);
+        sim.setCommonRandomNumbers(args.commonRandom);
+        sim.setDegradationName(degradationName(degradation));
+    };
+    
+    auto isExponential = [](const Cli::DistConfig& cfg) {
+        return dynamic_cast<ExponentialDist*>(Cli::createDist(cfg).get()) != nullptr;
+    };
+    if (!args.genericEngine && isExponential(workloadCfg) && isExponential(passiveCfg) && isExponential(serviceCfg)) {
+        std::visit([&](auto kernel) {
+            visit([&](RandomGenerator rng) {
+                auto workloadDist = Cli::createDist(workloadCfg);   // распределение ОБЪЁМА работы W_i
+                auto passiveDist = Cli::createDist(passiveCfg);     // распределение времени простоя
+                auto serviceTimeDist = Cli::createDist(serviceCfg);
+                auto sim = std::make_unique<ExponentialSimulator<decltype(kernel)>>(
+                    args.users,
+                    args.baseRate,
+                    downcast<ExponentialDist>(workloadDist),
+                    downcast<ExponentialDist>(passiveDist),
+                    downcast<ExponentialDist>(serviceTimeDist),
+                    kernel,
+                    std::move(rng)
+                );
+                configure(*sim);
+                return sim;
+            });
+        }, degradation);
+        return;
+    }
+    
+    visit([&](RandomGenerator rng) {
+        auto sim = std::make_unique<Simulator>(
+            args.users,
+            args.baseRate,
+            Cli::createDist(workloadCfg),
+            Cli::createDist(passiveCfg),
+            Cli::createDist(serviceCfg),
+            std::visit([](auto kernel) -> std::function<double(double)> { return kernel; }, degradation),
+            std::move(rng)
+        );
+        configure(*sim);
+        return sim;
+    });
+}
+
+// Один симулятор с потоком ГСЧ rng: visit получает ссылку на него
+template <class Visitor>
+void withSimulator(const Args& args, RandomGenerator rng, Visitor&& visit) {
+    withSimulatorFactory(args, [&](auto make) {
+        auto sim = make(std::move(rng));
+        visit(*sim);
+    });
+}
+
+// === Модель для аналитического решения ===
+// Простой и требование обслуживания приближаются фазовыми распределениями
+// (экспонента и ph: — без потерь); объём работы входит только через E[W]
+// (точно — для детерминированного)
+Analytic::Model analyticModel(const Args& args) {
+    auto passiveDist = Cli::createDist(Cli::parseDist(args.passiveDist));
+    auto serviceTimeDist = Cli::createDist(Cli::parseDist(args.serviceTimeDist));
+    auto serviceUnitMean = serviceTimeDist->rateScaledMean();
+    if (!serviceUnitMean)
+        throw std::invalid_argument("--analytic/--validate need a service-time distribution that scales with the "
+                                    "node rate (exp, gamma, lognorm or ph), got " + serviceTimeDist->name());
+    auto isPhaseType = [](const Distribution& d) {
+        return dynamic_cast<const ExponentialDist*>(&d) || dynamic_cast<const PhaseTypeDist*>(&d);
+    };
+    
+    auto workloadCfg = Cli::parseDist(args.workloadDist);
+    Analytic::Model model;
+    model.users = args.users;
+    model.passive = PhaseTypeDist::fit(*passiveDist, args.analyticPhases);
+    model.service = PhaseTypeDist::fit(*serviceTimeDist, args.analyticPhases).scaledToMean(*serviceUnitMean);
+    model.exactPhases = isPhaseType(*passiveDist) && isPhaseType(*serviceTimeDist);
+    model.baseRate = args.baseRate;
+    auto workloadDist = Cli::createDist(workloadCfg);
+    model.workloadMean = workloadDist->mean();
+    model.exactWorkload = workloadCfg.type == "det" || workloadCfg.type == "deterministic";
+    model.degradation = parseDegradationFn(args.degradationSpec);
+    
+    // Классы объёма работы: средние равновероятных групп упорядоченной выборки
+    if (args.analyticClasses > 1 && !model.exactWorkload) {
+        constexpr size_t kSamples = 1 << 18;
+        RandomGenerator rng(args.seed);
+        std::vector<double> samples(kSamples);
+        for (auto& x : samples) x = workloadDist->sample(rng);
+        std::sort(samples.begin(), samples.end());
+        for (int l = 0; l < args.analyticClasses; ++l) {
+            size_t lo = kSamples * l / args.analyticClasses;
+            size_t hi = kSamples * (l + 1) / args.analyticClasses;
+            model.workloadClasses.push_back(std::accumulate(samples.begin() + lo, samples.begin() + hi, 0.0) / (hi - lo));
+        }
+    }
+    return model;
+}
+
+// === Независимые прогоны на пуле потоков ===
+// Прогон r использует собственный поток ГСЧ (seed, r) и выполняется целиком
+// в одном рабочем потоке, поэтому результат не зависит от числа потоков.
+ReplicationSummary runReplications(const Args& args) {
+    std::vector<std::unique_ptr<SimulationStats>> results(args.replications);
+    
+    Parallel::forEach(results.size(), args.threads, [&](size_t r) {
+        withSimulator(args, createRng(args, r), [&](auto& sim) {
+            sim.runUntil(args.simTime);
+            results[r] = std::make_unique<SimulationStats>(sim.getStats());
+        });
+    });
+    
+    ReplicationSummary summary(args.users, results.front()->completionTime.method());
+    for (const auto& stats : results) summary.add(*stats);
+    return summary;
+}
+
+// === Кластер из --nodes узлов ===
+// Диспетчер использует поток ГСЧ 0, узел j — поток j + 1, поэтому результат
+// не зависит от --threads
+void runCluster(const Args& args) {
+    // Узлы растят состояние по числу своих задач (слотов), а не пользователей
+    Args nodeArgs = args;
+    nodeArgs.users = 1;
+    withSimulatorFactory(nodeArgs, [&](auto make) {
+        auto first = make(createRng(args, 1));
+        using Sim = typename decltype(first)::element_type;
+        std::vector<std::unique_ptr<Sim>> nodes;
+        nodes.push_back(std::move(first));
+        for (int j = 1; j < args.nodes; ++j) nodes.push_back(make(createRng(args, j + 1)));
+        
+        Cluster<Sim> cluster(
+            args.users,
+            std::move(nodes),
+            Cli::createDist(Cli::parseDist(args.workloadDist)),
+            Cli::createDist(Cli::parseDist(args.passiveDist)),
+            makeRoutingPolicy(args.routing),
+            args.dispatchDelay,
+            createRng(args, 0)
+        );
+        if (args.syncWindow > 0) cluster.setSyncWindow(args.syncWindow);
+        
+        auto start = std::chrono::steady_clock::now();
+        cluster.runUntil(args.simTime, args.threads);
+        double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        
+        cluster.printSummary();
+        std::cout << "Время выполнения:       " << std::fixed << std::setprecision(3) << wall << " сек ("
+                  << std::setprecision(0) << (wall > 0.0 ? cluster.eventsProcessed() / wall : 0.0)
+                  << " событий/сек, потоков: " << std::min<unsigned>(args.threads, args.nodes) << ")\n";
+        std::cout.unsetf(std::ios::floatfield);
+        
+        if (!args.csvOutput.empty()) saveDistributionToCSV(cluster.meanNodeDistribution(), args.csvOutput);
+    });
+}
+
+// === Перебор сетки параметров ===
+void applySweepParam(Args& args, const std::string& name, const std::string& value) {
+    if (name == "users") args.users = std::stoi(value);
+    else if (name == "time") args.simTime = std::stod(value);
+    else if (name == "base-rate") args.baseRate = std::stod(value);
+    else if (name == "degradation") args.degradationSpec = value;
+    else if (name == "workload") args.workloadDist = value;
+    else if (name == "service-time") args.serviceTimeDist = value;
+    else if (name == "passive") args.passiveDist = value;
+    else throw std::invalid_argument("Unsupported sweep axis: " + name);
+}
+
+// Каждая точка — один прогон с тем же семенем (общие случайные числа между
+// точками). Точки стартуют от самых дорогих (users × time), чтобы длинные
+// прогоны не оказались в хвосте; строки выводятся по мере готовности.
+void runSweep(const Args& args) {
+    auto axes = Sweep::parseSpec(args.sweepSpec);
+    auto points = Sweep::expand(axes);
+    
+    std::vector<Args> pointArgs;
+    pointArgs.reserve(points.size());
+    for (const auto& point : points) {
+        Args a = args;
+        for (const auto& kv : point) applySweepParam(a, kv.first, kv.second);
+        if (a.users <= 0 || a.simTime <= 0 || a.baseRate <= 0)
+            throw std::invalid_argument("Sweep point has non-positive users/time/base-rate");
+        pointArgs.push_back(a);
     }
     
-    const std::string& type = parts[0];
+    std::vector<size_t> order(points.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        return pointArgs[a].users * pointArgs[a].simTime > pointArgs[b].users * pointArgs[b].simTime;
+    });
     
-    // Гиперболическая: f(R) = 1 / (1 + R/R0)
-    if (type == "hyp" || type == "hyperbolic") {
-        if (parts.size() < 2) 
-            throw std::invalid_argument("hyperbolic requires 1 param: R0");
-        double R0 = std::stod(parts[1]);
-        if (R0 <= 0) throw std::invalid_argument("R0 must be positive");
-        return [R0](double R) -> double {
-            return 1.0 / (1.0 + R / R0);
-        };
+    std::ofstream file;
+    if (!args.sweepOutput.empty()) {
+        file.open(args.sweepOutput);
+        if (!file.is_open()) throw std::runtime_error("Cannot open sweep output: " + args.sweepOutput);
     }
+    std::ostream& out = args.sweepOutput.empty() ? std::cout : file;
+    
+    Sweep::RowWriter writer(out, args.sweepFormat == "json" ? Sweep::Format::Json : Sweep::Format::Csv, axes);
+    writer.writeHeader();
     
-    // Экспоненциальная: f(R) = exp(-alpha * R)
-    if (type == "exp" || type == "exponential") {
-        if (parts.size() < 2) 
-            throw std::invalid_argument("exponential requires 1 param: alpha");
-        double alpha = std::stod(parts[1]);
-        if (alpha < 0) throw std::invalid_argument("alpha must be non-negative");
-        return [alpha](double R) -> double {
-            return std::exp(-alpha * R);
-        };
+    Parallel::forEach(order.size(), args.threads, [&](size_t i) {
+        size_t index = order[i];
+        const Args& a = pointArgs[index];
+        withSimulator(a, createRng(a), [&](auto& sim) {
+            sim.runUntil(a.simTime);
+            writer.write(index, points[index], sim.getStats(), a.users);
+        });
+    });
+    
+    if (!args.sweepOutput.empty()) {
+        std::cerr << "  Sweep: " << points.size() << " points written to " << args.sweepOutput << "\n";
     }
+}
+
+// === Парное сравнение сценариев (--compare) ===
+RunMetrics runMetrics(const SimulationStats& stats, double passiveDrawn, double workloadDrawn, const Args& args) {
+    const double passiveMean = Cli::createDist(Cli::parseDist(args.passiveDist))->mean();
+    const double workloadMean = Cli::createDist(Cli::parseDist(args.workloadDist))->mean();
+    RunMetrics metrics;
+    metrics.utilization = stats.getNodeUtilization(args.users);
+    metrics.meanResponse = stats.completionTime.mean();
+    metrics.throughput = stats.totalSimulationTime > 0.0 ? stats.completionTime.count() / stats.totalSimulationTime : 0.0;
+    metrics.passiveDeviation = passiveMean != 0.0 ? passiveDrawn / passiveMean - 1.0 : 0.0;
+    metrics.workloadDeviation = workloadMean != 0.0 ? workloadDrawn / workloadMean - 1.0 : 0.0;
+    return metrics;
+}
+
+// Прогон r сценариев A и B берёт один и тот же поток ГСЧ r, а с
+// --antithetic прогоны 2i и 2i+1 — поток i и его антитетическую копию.
+// С --crn величины синхронизированы по пользователям, а не по порядку
+// обращений к общему потоку
+void runComparison(const Args& args) {
+    size_t eq = args.compareSpec.find('=');
+    if (eq == std::string::npos || eq == 0)
+        throw std::invalid_argument("--compare expects AXIS=VALUE, got " + args.compareSpec);
+    Args scenario = args;
+    applySweepParam(scenario, args.compareSpec.substr(0, eq), args.compareSpec.substr(eq + 1));
+    if (scenario.users <= 0 || scenario.simTime <= 0 || scenario.baseRate <= 0)
+        throw std::invalid_argument("--compare scenario has non-positive users/time/base-rate");
+    const Args* sides[2] = {&args, &scenario};
+    
+    std::vector<RunMetrics> metrics(2 * static_cast<size_t>(args.replications));
+    Parallel::forEach(metrics.size(), args.threads, [&](size_t task) {
+        size_t r = task / 2;
+        const Args& a = *sides[task % 2];
+        RandomGenerator rng = createRng(a, args.antithetic ? r / 2 : r);
+        rng.setAntithetic(args.antithetic && r % 2 == 1);
+        withSimulator(a, std::move(rng), [&](auto& sim) {
+            sim.runUntil(a.simTime);
+            metrics[task] = runMetrics(sim.getStats(), sim.drawnMean(RngSource::Passive),
+                                       sim.drawnMean(RngSource::Workload), a);
+        });
+    });
+    
+    PairedComparison comparison(args.antithetic, args.controlVariates);
+    for (size_t r = 0; r < metrics.size() / 2; ++r) comparison.add(metrics[2 * r], metrics[2 * r + 1]);
+    comparison.printSummary(args.compareSpec, args.commonRandom);
+}
+
+// === Расщепление RESTART (--restart) ===
+// Пороги — каждое k от --restart до N. Без --restart-factor R подбирается
+// по стационарному распределению цепи рождения–гибели среднего поля
+// (рождение (N−k)·λ, гибель k·μ₀·f(k·E[W])/E[S]): R_i ≈ π(k ≥ L_i) /
+// π(k ≥ L_{i+1}), т. е. Π R_i ≈ 1/π(k ≥ N) в пересчёте от L_1. Отношение
+// 1/q вероятностей шага вверх раньше шага вниз не годится: траектория
+// пересекает порог многократно, и число копий росло бы на каждом уровне.
+// Целые R подбираются так, чтобы накопленное произведение шло за точным.
+// Для распределений вне этой модели R лишь хуже подобраны — оценка
+// остаётся несмещённой
+std::vector<RestartLevel> restartLevels(const Args& args) {
+    constexpr long kMaxFactor = 100;
+    const int users = args.users;
+    auto passiveDist = Cli::createDist(Cli::parseDist(args.passiveDist));
+    auto serviceTimeDist = Cli::createDist(Cli::parseDist(args.serviceTimeDist));
+    const double workloadMean = Cli::createDist(Cli::parseDist(args.workloadDist))->mean();
+    const double serviceUnitMean = serviceTimeDist->rateScaledMean().value_or(serviceTimeDist->mean());
+    auto degradation = parseDegradationFn(args.degradationSpec);
     
-    // Линейная с обрезкой: f(R) = max(minFactor, 1 - R/Rmax)
-    if (type == "lin" || type == "linear") {
-        if (parts.size() < 2) 
-            throw std::invalid_argument("linear requires 1 param: Rmax");
-        double Rmax = std::stod(parts[1]);
-        if (Rmax <= 0) throw std::invalid_argument("Rmax must be positive");
-        const double minFactor = 0.1;  // минимальный множитель скорости
-        return [Rmax, minFactor](double R) -> double {
-            return std::max(minFactor, 1.0 - R / Rmax);
-        };
+    // log π(k) с точностью до константы и log π(k ≥ K) — в логарифмах,
+    // чтобы не переполниться при больших N
+    std::vector<double> logPi(users + 1, 0.0);
+    for (int k = 1; k <= users; ++k) {
+        double up = (users - k + 1) / passiveDist->mean();
+        double down = k * args.baseRate * degradation(k * workloadMean) / serviceUnitMean;
+        logPi[k] = logPi[k - 1] + std::log(up) - std::log(down);
+    }
+    std::vector<double> logTail(users + 2, -INFINITY);
+    for (int k = users; k >= 0; --k) {
+        double hi = std::max(logTail[k + 1], logPi[k]);
+        logTail[k] = hi + std::log(std::exp(logTail[k + 1] - hi) + std::exp(logPi[k] - hi));
     }
     
-    // Пороговая: f(R) = 1 if R<=Rt else min + (1-min)*Rt/R
-    if (type == "thr" || type == "threshold") {
-        if (parts.size() < 3) 
-            throw std::invalid_argument("threshold requires 2 params: Rt, minFactor");
-        double Rt = std::stod(parts[1]);
-        double minFactor = std::stod(parts[2]);
-        if (Rt <= 0 || minFactor < 0 || minFactor > 1) 
-            throw std::invalid_argument("Invalid threshold params");
-        return [Rt, minFactor](double R) -> double {
-            return (R <= Rt) ? 1.0 : minFactor + (1.0 - minFactor) * Rt / R;
-        };
+    std::vector<RestartLevel> levels;
+    double logProduct = 0.0;  // log Π R уже выбранных порогов
+    for (int k = args.restartFrom; k <= users; ++k) {
+        int factor = args.restartFactor;
+        if (factor == 0 && k == users) {
+            factor = levels.empty() ? 2 : levels.back().factor;  // выше N порогов нет
+        } else if (factor == 0) {
+            double target = logTail[args.restartFrom] - logTail[k + 1];
+            factor = static_cast<int>(std::clamp(std::lround(std::exp(target - logProduct)), 1L, kMaxFactor));
+        }
+        logProduct += std::log(factor);
+        levels.push_back({k, factor});
     }
+    return levels;
+}
+
+// Прогон r расщепления берёт поток r, обычный прогон — поток R + r;
+// повторные испытания — подпотоки потока своего прогона
+void runRestart(const Args& args) {
+    const auto levels = restartLevels(args);
+    const size_t runs = static_cast<size_t>(args.replications);
+    std::vector<SplittingRun> results(2 * runs);
+    
+    Parallel::forEach(results.size(), args.threads, [&](size_t task) {
+        const size_t r = task / 2;
+        const bool splitting = task % 2 == 0;
+        const RandomGenerator rng = createRng(args, splitting ? r : runs + r);
+        SplittingRun& run = results[task];
+        auto start = std::chrono::steady_clock::now();
+        withSimulator(args, rng, [&](auto& sim) {
+            using Sim = std::decay_t<decltype(sim)>;
+            sim.setPerUserStats(false);  // в отчёт идёт только P(k), копии дешевле
+            if (splitting) {
+                run = RestartSplitting<Sim>(levels, rng).run(sim, args.simTime);
+            } else {
+                sim.runUntil(args.simTime);
+                run.pk = sim.getStats().getProbabilityDistribution();
+                run.events = sim.getStats().totalEventsProcessed;
+            }
+        });
+        run.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    });
     
-    throw std::invalid_argument("Unknown degradation type: " + type);
+    SplittingSummary summary(args.users, args.simTime, levels);
+    for (size_t r = 0; r < runs; ++r) {
+        summary.addSplit(std::move(results[2 * r]));
+        summary.addCrude(std::move(results[2 * r + 1]));
+    }
+    summary.printSummary();
+    if (!args.csvOutput.empty()) saveDistributionToCSV(summary.meanProbabilityDistribution(), args.csvOutput);
 }
 
 // === Точка входа ===
@@ -195,62 +816,292 @@ int main(int argc, char* argv[]) {
         std::cerr << "Error: --base-rate must be positive\n";
         return 1;
     }
+    if (args.engine != "rescale" && args.engine != "vtime" && args.engine != "lumped") {
+        std::cerr << "Error: --engine must be 'rescale', 'vtime' or 'lumped'\n";
+        return 1;
+    }
+    if (args.replications <= 0) {
+        std::cerr << "Error: --replications must be positive\n";
+        return 1;
+    }
+    if (args.threads == 0) {
+        std::cerr << "Error: --threads must be positive\n";
+        return 1;
+    }
 
-    // Инициализация ГСЧ
-    RandomGenerator::instance().setSeed(args.seed);
+    if (args.precision < 0 || args.precisionPkMin < 0) {
+        std::cerr << "Error: --precision and --precision-pk-min must be non-negative\n";
+        return 1;
+    }
+    if (args.precision > 0 && (args.replications > 1 || !args.sweepSpec.empty())) {
+        std::cerr << "Error: --precision applies to a single run only\n";
+        return 1;
+    }
+    if (args.checkpointEvery < 0 || (args.checkpointEvery > 0 && args.checkpointFile.empty())) {
+        std::cerr << "Error: --checkpoint-every must be non-negative and needs --checkpoint\n";
+        return 1;
+    }
+    bool checkpointing = !args.checkpointFile.empty() || !args.resumeFile.empty();
+    if (checkpointing && (args.replications > 1 || !args.sweepSpec.empty() || args.precision > 0)) {
+        std::cerr << "Error: --checkpoint/--resume apply to a single fixed-time run only\n";
+        return 1;
+    }
+    if (!args.asyncSnapshots.empty() && args.asyncSnapshots != "block" && args.asyncSnapshots != "drop") {
+        std::cerr << "Error: --async-snapshots must be 'block' or 'drop'\n";
+        return 1;
+    }
+    if (args.snapshotFormat != "csv" && args.snapshotFormat != "bin" && args.snapshotFormat != "none") {
+        std::cerr << "Error: --snapshot-format must be 'csv', 'bin' or 'none'\n";
+        return 1;
+    }
+    if (args.monitorInterval <= 0 || args.monitorWindow < 0) {
+        std::cerr << "Error: --monitor-interval must be positive, --monitor-window non-negative\n";
+        return 1;
+    }
+    if (args.monitorWindow > 0 && args.snapshotFormat == "bin") {
+        std::cerr << "Error: --monitor-window is supported with --snapshot-format csv only\n";
+        return 1;
+    }
+    if (args.snapshotQueue == 0) {
+        std::cerr << "Error: --snapshot-queue must be positive\n";
+        return 1;
+    }
+    if (args.sweepFormat != "csv" && args.sweepFormat != "json") {
+        std::cerr << "Error: --sweep-format must be 'csv' or 'json'\n";
+        return 1;
+    }
+    if (args.quantiles != "hdr" && args.quantiles != "tdigest") {
+        std::cerr << "Error: --quantiles must be 'hdr' or 'tdigest'\n";
+        return 1;
+    }
+    if ((args.analytic || args.validate) && (args.replications > 1 || !args.sweepSpec.empty())) {
+        std::cerr << "Error: --analytic and --validate apply to a single run only\n";
+        return 1;
+    }
+    if (args.analyticPhases < 1 || args.analyticClasses < 1) {
+        std::cerr << "Error: --analytic-phases and --analytic-classes must be positive\n";
+        return 1;
+    }
+    if (args.analytic && args.validate) {
+        std::cerr << "Error: --analytic and --validate are mutually exclusive\n";
+        return 1;
+    }
+    if (args.profile && !Profiler::kCompiled) {
+        std::cerr << "Error: --profile needs a build configured with -DSIMULATOR_PROFILE=ON\n";
+        return 1;
+    }
+    if (args.profile && (args.replications > 1 || !args.sweepSpec.empty())) {
+        std::cerr << "Error: --profile applies to a single run only\n";
+        return 1;
+    }
+    if (args.rngEngine != "xoshiro" && args.rngEngine != "philox") {
+        std::cerr << "Error: --rng must be 'xoshiro' or 'philox'\n";
+        return 1;
+    }
+    bool comparing = !args.compareSpec.empty();
+    if ((args.antithetic || args.controlVariates) && !comparing) {
+        std::cerr << "Error: --antithetic and --control-variates apply to --compare\n";
+        return 1;
+    }
+    if (args.antithetic && !args.commonRandom) {
+        std::cerr << "Error: --antithetic needs --crn (antithetic pairs are built from per-user substreams)\n";
+        return 1;
+    }
+    if (comparing && (args.replications < 2 || (args.antithetic && (args.replications < 4 || args.replications % 2)))) {
+        std::cerr << "Error: --compare needs --replications >= 2 (an even number >= 4 with --antithetic)\n";
+        return 1;
+    }
+    if (args.controlVariates && args.replications / (args.antithetic ? 2 : 1) < 10) {
+        std::cerr << "Error: --control-variates needs at least 10 units (--replications >= 10, >= 20 with --antithetic)\n";
+        return 1;
+    }
+    if (comparing && (!args.sweepSpec.empty() || args.analytic || args.validate || checkpointing
+                      || args.precision > 0 || args.profile)) {
+        std::cerr << "Error: --compare does not combine with --sweep, --analytic, --validate, --checkpoint, "
+                     "--precision or --profile\n";
+        return 1;
+    }
+    if (args.commonRandom && (args.engine == "lumped" || checkpointing)) {
+        std::cerr << "Error: --crn needs --engine rescale or vtime and does not support --checkpoint/--resume\n";
+        return 1;
+    }
+    if (args.nodes <= 0) {
+        std::cerr << "Error: --nodes must be positive\n";
+        return 1;
+    }
+    if (args.dispatchDelay <= 0 || args.syncWindow < 0 || args.syncWindow > args.dispatchDelay) {
+        std::cerr << "Error: --dispatch-delay must be positive and --sync-window in (0, dispatch delay]\n";
+        return 1;
+    }
+    if (args.routing != "random" && args.routing != "round-robin" && args.routing != "rr"
+        && args.routing != "jsq" && args.routing != "least-degraded") {
+        std::cerr << "Error: --routing must be 'random', 'round-robin', 'jsq' or 'least-degraded'\n";
+        return 1;
+    }
+    if (args.nodes > 1 && (args.replications > 1 || !args.sweepSpec.empty() || args.analytic || args.validate
+                           || checkpointing || args.precision > 0 || args.profile || comparing || args.commonRandom)) {
+        std::cerr << "Error: --nodes runs a single fixed-time simulation; it does not combine with "
+                     "--replications, --sweep, --analytic, --validate, --checkpoint, --precision, --profile, "
+                     "--compare or --crn\n";
+        return 1;
+    }
+    bool splitting = args.restartFrom != 0;
+    if (args.restartFactor < 0 || (args.restartFactor > 0 && !splitting)) {
+        std::cerr << "Error: --restart-factor must be positive and needs --restart\n";
+        return 1;
+    }
+    if (splitting && (args.restartFrom < 1 || args.restartFrom > args.users || args.replications < 2)) {
+        std::cerr << "Error: --restart needs a threshold in [1, users] and --replications >= 2\n";
+        return 1;
+    }
+    if (splitting && (args.nodes > 1 || !args.sweepSpec.empty() || args.analytic || args.validate || checkpointing
+                      || args.precision > 0 || args.profile || comparing || args.commonRandom)) {
+        std::cerr << "Error: --restart does not combine with --nodes, --sweep, --analytic, --validate, "
+                     "--checkpoint, --precision, --profile, --compare or --crn\n";
+        return 1;
+    }
+    if (args.nodes > 1 && args.engine == "lumped") {
+        std::cerr << "Error: cluster nodes need --engine rescale or vtime\n";
+        return 1;
+    }
+    
+    // Перебор сетки: только строки результатов, без шапки и сводки
+    if (!args.sweepSpec.empty()) {
+        try {
+            runSweep(args);
+        } catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << "\n";
+            return 1;
+        }
+        return 0;
+    }
     
     // Информационный вывод
     std::cout << "=== Scientific Simulator (Stretching Method) ===\n"
               << "Users:        " << args.users << "\n"
               << "Time:         " << args.simTime << " sec\n"
-              << "Seed:         " << args.seed << "\n"
+              << "Seed:         " << args.seed << " (" << args.rngEngine << ")\n"
               << "Base rate:    " << args.baseRate << " work/sec\n"
               << "Workload:     " << args.workloadDist << "\n"
               << "Service time: " << args.serviceTimeDist << "\n"
               << "Passive:      " << args.passiveDist << "\n"
-              << "Degradation:  " << args.degradationSpec << "\n\n";
+              << "Degradation:  " << args.degradationSpec << "\n"
+              << "Engine:       " << args.engine << "\n";
+    if (args.precision > 0) {
+        std::cout << "Precision:    " << args.precision << " (relative 95% CI half-width, --time is the cap)\n";
+    }
+    if (args.nodes > 1) {
+        std::cout << "Cluster:      " << args.nodes << " nodes, routing " << args.routing
+                  << ", dispatch delay " << args.dispatchDelay << " sec (threads: " << args.threads << ")\n";
+    }
+    if (comparing) {
+        std::cout << "Compare:      B = " << args.compareSpec
+                  << (args.commonRandom ? " (common random numbers)" : "") << "\n";
+    }
+    if (splitting) {
+        std::cout << "Splitting:    RESTART, thresholds k = " << args.restartFrom << ".." << args.users
+                  << ", factor " << (args.restartFactor > 0 ? std::to_string(args.restartFactor) : "auto") << "\n";
+    }
+    if (args.replications > 1) {
+        std::cout << "Replications: " << args.replications
+                  << " (threads: " << args.threads << ")\n";
+    }
+    std::cout << "\n";
 
     try {
-        // === Парсинг распределений ===
-        auto workloadCfg = Cli::parseDist(args.workloadDist);
-        auto passiveCfg = Cli::parseDist(args.passiveDist);
-        auto serviceCfg = Cli::parseDist(args.serviceTimeDist);
-        
-        auto workloadDist = Cli::createDist(workloadCfg);   // распределение ОБЪЁМА работы W_i
-        auto serviceTimeDist = Cli::createDist(serviceCfg);
-        auto passiveDist = Cli::createDist(passiveCfg);     // распределение времени простоя
+        std::optional<Analytic::Result> analytic;
+        if (args.analytic || args.validate) analytic = Analytic::solve(analyticModel(args), args.threads);
         
-        // === Создание функции деградации ===
-        auto degradationFn = parseDegradationFn(args.degradationSpec);
+        if (args.analytic) {
+            Analytic::printSummary(*analytic, args.users, args.simTime);
+            if (!args.csvOutput.empty()) saveDistributionToCSV(analytic->pk, args.csvOutput);
+            return 0;
+        }
         
-        // === Создание и запуск симулятора ===
-        // Конструктор: (maxUsers, baseRate, workloadDist, passiveDist, degradationFn)
-        Simulator sim(
-            args.users,
-            args.baseRate,
-            std::move(workloadDist),
-            std::move(passiveDist),
-            std::move(serviceTimeDist), 
-            degradationFn
-        );
-
-        CsvStatisticsCollector csvCollector("simulation_data.csv");
-
-        sim.attachListener(&csvCollector);
+        if (args.nodes > 1) {
+            runCluster(args);
+            return 0;
+        }
         
-        sim.runUntil(args.simTime);
+        if (comparing) {
+            runComparison(args);
+            return 0;
+        }
         
-        // === Вывод результатов ===
-        sim.getStats().printSummary(args.users);
+        if (splitting) {
+            runRestart(args);
+            return 0;
+        }
         
-        // === Сохранение распределения P(k) в CSV ===
-        if (!args.csvOutput.empty()) {
-            saveDistributionToCSV(
-                sim.getStats().getProbabilityDistribution(), 
-                args.csvOutput
-            );
+        if (args.replications > 1) {
+            auto summary = runReplications(args);
+            summary.printSummary();
+            
+            if (!args.csvOutput.empty()) {
+                saveDistributionToCSV(summary.meanProbabilityDistribution(), args.csvOutput);
+            }
+            return 0;
         }
         
+        // === Создание и запуск симулятора ===
+        withSimulator(args, createRng(args), [&](auto& sim) {
+            auto snapshots = createSnapshotListener(args);
+            sim.attachListener(snapshots.get());
+            sim.setMonitorInterval(args.monitorInterval);
+            sim.setAggregationWindow(args.monitorWindow);
+            if (args.profile) sim.profiler().enable();
+            
+            SequentialStopping stopping(args.users, args.precision, args.precisionPkMin);
+            if (args.precision > 0) sim.setStoppingRule(&stopping);
+            
+            if (!args.resumeFile.empty()) {
+                sim.loadCheckpoint(args.resumeFile);
+                std::cout << "Resumed from " << args.resumeFile << " at t = " << sim.currentTime() << " sec\n";
+                if (args.simTime < sim.currentTime())
+                    throw std::invalid_argument("--time is before the checkpoint time");
+            }
+            
+            // Прогон кусками по --checkpoint-every с сохранением после каждого
+            if (args.checkpointEvery > 0) {
+                for (double t = sim.currentTime() + args.checkpointEvery; t < args.simTime; t += args.checkpointEvery) {
+                    sim.runUntil(t);
+                    sim.saveCheckpoint(args.checkpointFile);
+                }
+            }
+            sim.runUntil(args.simTime);
+            if (!args.checkpointFile.empty()) sim.saveCheckpoint(args.checkpointFile);
+            sim.finalize();
+            
+            // === Вывод результатов ===
+            sim.getStats().printSummary(args.users);
+            std::cout << "Память состояния:       " << std::fixed << std::setprecision(1)
+                      << static_cast<double>(sim.stateBytes()) / args.users << " байт/пользователь ("
+                      << sim.stateBytes() / (1024.0 * 1024.0) << " МБ)\n";
+            if (args.precision > 0) stopping.printSummary(sim.getStats().totalSimulationTime);
+            if (analytic) Analytic::printValidation(*analytic, sim.getStats(), args.users);
+            if (auto* async = dynamic_cast<AsyncListener*>(snapshots.get())) {
+                std::cout << "\nСнимки (фоновая запись): " << async->delivered() << " записано, "
+                          << async->dropped() << " отброшено, макс. глубина очереди "
+                          << async->maxDepth() << " / " << async->capacity() << "\n";
+            }
+            if (args.profile) {
+                sim.profiler().print(std::cout);
+                if (!args.profileJson.empty()) {
+                    std::ofstream out(args.profileJson);
+                    if (!out) throw std::runtime_error("Cannot open profile file: " + args.profileJson);
+                    sim.profiler().writeJson(out);
+                }
+            }
+            
+            // === Сохранение распределения P(k) в CSV ===
+            if (!args.csvOutput.empty()) {
+                saveDistributionToCSV(
+                    sim.getStats().getProbabilityDistribution(), 
+                    args.csvOutput
+                );
+            }
+        });
+        
     } catch (const std::exception& e) {
         std::cerr << "Error: " << e.what() << "\n";
         printHelp();
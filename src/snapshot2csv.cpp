@@ -0,0 +1,43 @@
+// snapshot2csv.cpp — преобразование двоичных снимков (.bin) в CSV
+#include "SnapshotFormat.h"
+#include "CsvStatisticsCollector.h"
+
+#include <iostream>
+#include <string>
+
+// Usage: snapshot2csv INPUT.bin [OUTPUT.csv]
+// Формат строк совпадает с CsvStatisticsCollector (simulation_data.csv)
+int main(int argc, char* argv[]) {
+    if (argc < 2 || argc > 3 || std::string(argv[1]) == "--help" || std::string(argv[1]) == "-h") {
+        std::cerr << "Usage: snapshot2csv INPUT.bin [OUTPUT.csv]\n"
+                  << "Converts a binary snapshot file (--snapshot-format bin) to CSV.\n"
+                  << "Without OUTPUT the file name is INPUT with the extension replaced by .csv\n";
+        return argc < 2 ? 1 : 0;
+    }
+
+    std::string input = argv[1];
+    std::string output;
+    if (argc == 3) {
+        output = argv[2];
+    } else {
+        auto dot = input.find_last_of('.');
+        output = (dot == std::string::npos ? input : input.substr(0, dot)) + ".csv";
+    }
+
+    try {
+        SnapshotFormat::Reader reader(input);
+        CsvStatisticsCollector csv(output);
+        SnapshotFormat::Block block;
+        for (size_t i = 0; i < reader.index().size(); ++i) {
+            reader.readBlock(i, block);
+            for (size_t r = 0; r < block.size(); ++r) csv.onSnapshot(block.row(r));
+        }
+        csv.onSimulationEnd();
+        std::cerr << reader.totalRows() << " rows in " << reader.index().size()
+                  << " blocks -> " << output << "\n";
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}